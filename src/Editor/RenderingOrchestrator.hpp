@@ -5,6 +5,10 @@
 #include <imgui.h>
 
 #include "Utils/DrawingHelper.hpp"
+#include "Utils/CpuFeatures.hpp"
+#include "Utils/JobSystem.hpp"
+#include "Renderer/SectorPvs.hpp"
+#include "Renderer/RaycastingMathSimd.hpp"
 
 class RenderingOrchestrator
 {
@@ -17,13 +21,20 @@ public:
     {
         if(play)
         {
+            // Nothing moved since the last frame, renderTexture still holds its image
+            if(skipUnchangedFrames && rasterizer.IsFrameUpToDate(renderTexture.texture.width, renderTexture.texture.height, world, cam))
+            {
+                ++skippedFramesCount;
+                return;
+            }
+
             AllRenderItr(world, cam);
         }
         else
         {
             switch(invokeEvent)
             {
-                case StepInto: OneRenderItr(world, cam); break;
+                case StepInto: OneRenderItr(world, cam, true); break;
                 case StepOver: AllRenderItr(world, cam); break;
                 case None:
                     break;
@@ -36,6 +47,7 @@ public:
     void InitializeFrame(World &world, RaycastingCamera &cam)
     {
         rasterizer.Reset(renderTexture.texture.width, renderTexture.texture.height, world, cam);
+        ++frameIndex;
 
         if(!rasterizingItrsTextures.empty())
         {
@@ -52,21 +64,39 @@ public:
             }
         }
 
-        if(rasterizingItrsTextures.size() != cam.maxRenderItr)
+        if(rasterizingItrsTextures.size() != cam.maxPortalDepth)
         {
-            rasterizingItrsTextures.resize(cam.maxRenderItr, { 0 });
+            rasterizingItrsTextures.resize(cam.maxPortalDepth, { 0 });
+            rasterizingItrsFrames.resize(cam.maxPortalDepth, 0);
         }
     }
 
     void AllRenderItr(World &world, RaycastingCamera &cam)
     {
+        // Whole framebuffer frames go through RasterizeWorld, which may split them across threads
+        if(!rasterizer.IsRenderIterationRemains() && rasterizer.GetBackend() == RasterizerBackend::Framebuffer)
+        {
+            InitializeFrame(world, cam);
+
+            rasterizer.RasterizeWorld();
+            rasterizer.UploadFramebufferToTexture(renderTexture.texture);
+            return;
+        }
+
         do
         {
-            OneRenderItr(world, cam);
+            OneRenderItr(world, cam, false);
         } while(rasterizer.IsRenderIterationRemains());
+
+        // The framebuffer is uploaded once for the whole frame
+        if(rasterizer.GetContext().backend == RasterizerBackend::Framebuffer)
+        {
+            rasterizer.UploadFramebufferToTexture(renderTexture.texture);
+        }
     }
 
-    void OneRenderItr(World &world, RaycastingCamera &cam)
+    // With the Framebuffer backend the iteration only reaches renderTexture (and its capture) when uploadIteration is set
+    void OneRenderItr(World &world, RaycastingCamera &cam, bool uploadIteration)
     {
         if(!rasterizer.IsRenderIterationRemains())
         {
@@ -76,21 +106,39 @@ public:
         assert(rasterizer.IsRenderIterationRemains());
 
         auto& ctx = rasterizer.GetContext();
-    
-        BeginTextureMode(renderTexture);
 
+        if(ctx.backend == RasterizerBackend::Framebuffer)
+        {
             if(ctx.currentRenderItr == 0)
             {
-                ClearBackground(MY_BLACK);
+                rasterizer.ClearRenderTarget();
             }
 
             rasterizer.RenderIteration();
-            
-        EndTextureMode();
 
-        assert(rasterizingItrsTextures.size() >= ctx.currentRenderItr);
+            if(!uploadIteration) return;
+
+            rasterizer.UploadFramebufferToTexture(renderTexture.texture);
+        }
+        else
+        {
+            BeginTextureMode(renderTexture);
+
+                if(ctx.currentRenderItr == 0)
+                {
+                    rasterizer.ClearRenderTarget();
+                }
+
+                rasterizer.RenderIteration();
+                
+            EndTextureMode();
+        }
+
         assert(ctx.currentRenderItr > 0);
 
+        // One texture per portal depth level, visits past that count are not captured
+        if(ctx.currentRenderItr > rasterizingItrsTextures.size()) return;
+
         auto& texture = rasterizingItrsTextures.at(ctx.currentRenderItr - 1);
 
         if(texture.id == 0)
@@ -101,6 +149,8 @@ public:
         BeginTextureMode(texture);
             DrawTextureFlippedY(renderTexture.texture, 0, 0, WHITE);
         EndTextureMode();
+
+        rasterizingItrsFrames.at(ctx.currentRenderItr - 1) = frameIndex;
     }
 
     void DrawGUI()
@@ -125,13 +175,94 @@ public:
                 invokeEvent = StepOver;
             }
 
+            {
+                constexpr const char* RasterizationModeLabels[] = { "Ray", "Wall Span", "SIMD Batch", "Ray Packet" };
+
+                int rasterizationMode = static_cast<int>(rasterizer.GetRasterizationMode());
+                if(ImGui::Combo("Rasterization", &rasterizationMode, RasterizationModeLabels, IM_ARRAYSIZE(RasterizationModeLabels)))
+                {
+                    rasterizer.SetRasterizationMode(static_cast<RasterizationMode>(rasterizationMode));
+                }
+
+                ImGui::Text("SIMD : %s, scalar : %s", SimdLevelName(GetRasterSimdLevel()), RasterScalarName());
+
+                constexpr const char* BackendLabels[] = { "Raylib", "Framebuffer" };
+
+                int backend = static_cast<int>(rasterizer.GetBackend());
+                if(ImGui::Combo("Backend", &backend, BackendLabels, IM_ARRAYSIZE(BackendLabels)))
+                {
+                    rasterizer.SetBackend(static_cast<RasterizerBackend>(backend));
+                }
+
+                if(rasterizer.GetBackend() == RasterizerBackend::Framebuffer)
+                {
+                    constexpr const char* FramebufferFormatLabels[] = { "RGBA", "Palettized 8 bit" };
+
+                    int framebufferFormat = static_cast<int>(rasterizer.GetFramebufferFormat());
+                    if(ImGui::Combo("Pixel Format", &framebufferFormat, FramebufferFormatLabels, IM_ARRAYSIZE(FramebufferFormatLabels)))
+                    {
+                        rasterizer.SetFramebufferFormat(static_cast<FramebufferFormat>(framebufferFormat));
+                    }
+                }
+
+                constexpr const char* ParallelismLabels[] = { "Serial", "Column Strips", "Portal Tasks" };
+
+                int parallelism = static_cast<int>(rasterizer.GetParallelism());
+                if(ImGui::Combo("Threading", &parallelism, ParallelismLabels, IM_ARRAYSIZE(ParallelismLabels)))
+                {
+                    rasterizer.SetParallelism(static_cast<RasterizerParallelism>(parallelism));
+                }
+
+                constexpr const char* SchedulerLabels[] = { "Depth First", "Breadth First" };
+
+                int scheduler = static_cast<int>(rasterizer.GetScheduler());
+                if(ImGui::Combo("Scheduler", &scheduler, SchedulerLabels, IM_ARRAYSIZE(SchedulerLabels)))
+                {
+                    rasterizer.SetScheduler(static_cast<RenderAreaScheduler>(scheduler));
+                }
+
+                if(rasterizer.GetParallelism() != RasterizerParallelism::Serial)
+                {
+                    ImGui::Text("Workers : %u %s", GetJobSystem().GetWorkersCount(), 
+                        rasterizer.GetBackend() == RasterizerBackend::Framebuffer ? "" : "(needs the Framebuffer backend)");
+                }
+
+                ImGui::Checkbox("Skip unchanged frames", &skipUnchangedFrames);
+                ImGui::SameLine();
+                ImGui::Text("(%llu skipped)", static_cast<unsigned long long>(skippedFramesCount));
+
+                // Should stay at 0 once the first frames have sized the rasterizer buffers
+                const RasterizeWorldContext& ctx = rasterizer.GetContext();
+                ImGui::Text("Frame allocations : %llu", static_cast<unsigned long long>(rasterizer.GetFrameAllocationsCount()));
+                ImGui::Text("Frame arena : %zu bytes", ctx.frameArena.GetCapacity());
+
+                if(ctx.world != nullptr && ctx.camSectorIndex != NULL_SECTOR_INDEX)
+                {
+                    ImGui::Text("Potentially visible sectors : %u / %zu%s", 
+                        CountPotentiallyVisibleSectors(*ctx.world, ctx.camSectorIndex), ctx.world->sectors.size(),
+                        rasterizer.IsBuildingPvs() ? " (building)" : "");
+                }
+
+                const WallTextureCache& textureCache = rasterizer.GetWallTextureCache();
+                ImGui::Text("Wall textures : %u resident, %.1f / %.1f MB, %u pending", textureCache.residentTexturesCount,
+                    textureCache.residentBytes / (1024.f * 1024.f), textureCache.budgetBytes / (1024.f * 1024.f), textureCache.pendingLoadsCount);
+                ImGui::Text("Texture loads : %llu, evictions : %llu",
+                    static_cast<unsigned long long>(textureCache.loadsCount), static_cast<unsigned long long>(textureCache.evictionsCount));
+
+                if(rasterizer.GetRasterizationMode() == RasterizationMode::Ray)
+                {
+                    ImGui::Text("Coherent columns : %.1f %%", rasterizer.GetCoherentColumnsRate() * 100.f);
+                }
+            }
+
             // Render Iterations UI
             {
                 auto& ctx = rasterizer.GetContext();
             
                 for(size_t i = 0; auto& texture : rasterizingItrsTextures)
                 {
-                    if(texture.id != 0 && i < ctx.currentRenderItr)
+                    // Skip the iterations the framebuffer backend did not upload this frame
+                    if(texture.id != 0 && i < ctx.currentRenderItr && rasterizingItrsFrames[i] == frameIndex)
                     {
                         ImGui::Text("Iteration - %d", i);
                         rlImGuiImageRenderTextureFitWidth(&texture);
@@ -149,8 +280,13 @@ private:
     WorldRasterizer rasterizer;
 
     bool play = true;
+    bool skipUnchangedFrames = true;
+    uint64_t skippedFramesCount { 0 };
     enum InvokeEvent { None, StepInto, StepOver };
     InvokeEvent invokeEvent { None };
     std::vector<RenderTexture> rasterizingItrsTextures;
+    // Frame in which each iteration texture was last captured
+    std::vector<uint64_t> rasterizingItrsFrames;
+    uint64_t frameIndex { 0 };
 };
 
@@ -282,7 +282,11 @@ void WorldEditor::RenderSectorsGui()
 
             if (sectorOpen)
             {
-                RenderSectorContentGui(sector);
+                if(RenderSectorContentGui(sector))
+                {
+                    world.MarkModified();
+                }
+
                 ImGui::TreePop();
             }
         }
@@ -290,10 +294,12 @@ void WorldEditor::RenderSectorsGui()
     ImGui::End();
 }
 
-void WorldEditor::RenderSectorContentGui(Sector& sector)
+bool WorldEditor::RenderSectorContentGui(Sector& sector)
 {
-    ImGui::SliderFloat("zCeiling", &sector.zCeiling, -10, 10);
-    ImGui::SliderFloat("zFloor", &sector.zFloor, -10, 10);
+    bool modified = false;
+
+    modified |= ImGui::SliderFloat("zCeiling", &sector.zCeiling, -10, 10);
+    modified |= ImGui::SliderFloat("zFloor", &sector.zFloor, -10, 10);
 
     for(size_t i = 0; i < sector.walls.size(); ++i)
     {
@@ -308,6 +314,8 @@ void WorldEditor::RenderSectorContentGui(Sector& sector)
             ImGui::Text("[%zu] => NULL", i);
         }
     }
+
+    return modified;
 }
 
 int32_t WorldEditor::GetGridCellSize() const
@@ -50,7 +50,8 @@ private:
 
     void RenderViewportGui();
     void RenderSectorsGui();
-    static void RenderSectorContentGui(Sector& sector);
+    // Returns true when the sector has been modified
+    static bool RenderSectorContentGui(Sector& sector);
 
 private:
     World& world;
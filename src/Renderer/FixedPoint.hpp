@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <compare>
+#include <limits>
+
+/// 16.16 signed fixed point number, integer arithmetic only so results do not depend on the compiler
+/// or its float settings. Operations saturate instead of wrapping, the range is about [-32768, 32768[.
+struct Fixed16
+{
+    static constexpr int32_t FractionBits = 16;
+    static constexpr int64_t One = int64_t(1) << FractionBits;
+
+    int32_t raw { 0 };
+
+    constexpr auto operator<=>(const Fixed16&) const = default;
+};
+
+/// Product of two Fixed16 kept whole, 32.32. Cross products of world coordinates overflow a Fixed16,
+/// they are summed and compared in this form, then brought back by WideQuotient or WideSqrt.
+struct Fixed16Wide
+{
+    int64_t raw { 0 };
+
+    constexpr auto operator<=>(const Fixed16Wide&) const = default;
+};
+
+constexpr Fixed16 SaturateFixed16(int64_t raw)
+{
+    if(raw > std::numeric_limits<int32_t>::max()) return { std::numeric_limits<int32_t>::max() };
+    if(raw < std::numeric_limits<int32_t>::min()) return { std::numeric_limits<int32_t>::min() };
+
+    return { static_cast<int32_t>(raw) };
+}
+
+constexpr Fixed16 Fixed16FromInt(int64_t value)
+{
+    return SaturateFixed16(value * Fixed16::One);
+}
+
+// Rounds to the nearest, NaN gives 0
+constexpr Fixed16 Fixed16FromFloat(float value)
+{
+    if(value != value) return {};
+    if(value >= 32768.f) return { std::numeric_limits<int32_t>::max() };
+    if(value <= -32768.f) return { std::numeric_limits<int32_t>::min() };
+
+    // Exact in double, the conversion is the only rounding
+    const double scaled = static_cast<double>(value) * Fixed16::One;
+    return SaturateFixed16(static_cast<int64_t>(scaled >= 0 ? scaled + 0.5 : scaled - 0.5));
+}
+
+constexpr float Fixed16ToFloat(Fixed16 value)
+{
+    return static_cast<float>(value.raw) * (1.f / 65536.f);
+}
+
+constexpr Fixed16 operator+(Fixed16 a, Fixed16 b) { return SaturateFixed16(int64_t(a.raw) + b.raw); }
+constexpr Fixed16 operator-(Fixed16 a, Fixed16 b) { return SaturateFixed16(int64_t(a.raw) - b.raw); }
+constexpr Fixed16 operator-(Fixed16 a) { return SaturateFixed16(-int64_t(a.raw)); }
+constexpr Fixed16 operator*(Fixed16 a, Fixed16 b) { return SaturateFixed16((int64_t(a.raw) * b.raw) >> Fixed16::FractionBits); }
+
+constexpr Fixed16 operator/(Fixed16 a, Fixed16 b)
+{
+    if(b.raw == 0) return SaturateFixed16(a.raw >= 0 ? std::numeric_limits<int64_t>::max() : std::numeric_limits<int64_t>::min());
+
+    return SaturateFixed16((int64_t(a.raw) * Fixed16::One) / b.raw);
+}
+
+constexpr Fixed16& operator+=(Fixed16& a, Fixed16 b) { return a = a + b; }
+constexpr Fixed16& operator-=(Fixed16& a, Fixed16 b) { return a = a - b; }
+
+constexpr Fixed16Wide operator+(Fixed16Wide a, Fixed16Wide b) { return { a.raw + b.raw }; }
+constexpr Fixed16Wide operator-(Fixed16Wide a, Fixed16Wide b) { return { a.raw - b.raw }; }
+constexpr Fixed16Wide operator-(Fixed16Wide a) { return { -a.raw }; }
+
+constexpr Fixed16Wide WideProduct(Fixed16 a, Fixed16 b)
+{
+    return { int64_t(a.raw) * b.raw };
+}
+
+// numerator / denominator, truncated toward zero
+constexpr Fixed16 WideQuotient(Fixed16Wide numerator, Fixed16Wide denominator)
+{
+    int64_t n = numerator.raw;
+    int64_t d = denominator.raw;
+
+    if(d == 0) return SaturateFixed16(n >= 0 ? std::numeric_limits<int64_t>::max() : std::numeric_limits<int64_t>::min());
+
+    // The remainder is scaled by 2^16 below, large denominators lose low bits far under the result precision
+    constexpr int64_t MaxDenominator = int64_t(1) << 46;
+    while(d >= MaxDenominator || d <= -MaxDenominator)
+    {
+        n /= 2;
+        d /= 2;
+    }
+
+    const int64_t quotient = n / d;
+    if(quotient >= 32768) return { std::numeric_limits<int32_t>::max() };
+    if(quotient <= -32768) return { std::numeric_limits<int32_t>::min() };
+
+    return { static_cast<int32_t>(quotient * Fixed16::One + ((n % d) * Fixed16::One) / d) };
+}
+
+// Rounded down, negative values give 0
+inline Fixed16 WideSqrt(Fixed16Wide value)
+{
+    if(value.raw <= 0) return {};
+
+    // sqrt(v * 2^32) = sqrt(v) * 2^16, the integer root of the 32.32 value is the 16.16 result.
+    // IEEE sqrt is correctly rounded everywhere, the integer steps then make the root exact
+    const uint64_t v = static_cast<uint64_t>(value.raw);
+    uint64_t root = static_cast<uint64_t>(std::sqrt(static_cast<double>(v)));
+
+    while(root * root > v) --root;
+    while((root + 1) * (root + 1) <= v) ++root;
+
+    return SaturateFixed16(static_cast<int64_t>(root));
+}
+
+constexpr float WideToFloat(Fixed16Wide value)
+{
+    return static_cast<float>(value.raw) * (1.f / 4294967296.f);
+}
+
+// Half away from zero, like roundf
+constexpr Fixed16 Fixed16Round(Fixed16 value)
+{
+    constexpr int64_t Half = Fixed16::One / 2;
+    constexpr int64_t FractionMask = Fixed16::One - 1;
+
+    const int64_t raw = value.raw;
+    return SaturateFixed16(raw >= 0 ? ((raw + Half) & ~FractionMask) : -((-raw + Half) & ~FractionMask));
+}
+
+constexpr Fixed16 Fixed16Radians(Fixed16 degrees)
+{
+    // pi / 180 in 0.32
+    constexpr int64_t DegreeToRadian = 74961321;
+
+    return SaturateFixed16((int64_t(degrees.raw) * DegreeToRadian) >> 32);
+}
+
+// Sine of an angle in 2.30 radians, range reduced then Taylor series up to x^11 (error under 1e-7)
+constexpr Fixed16 Fixed16SinQ30(int64_t angle)
+{
+    constexpr int64_t OneQ30 = int64_t(1) << 30;
+    constexpr int64_t PiQ30 = 3373259426;
+    constexpr int64_t HalfPiQ30 = 1686629713;
+
+    int64_t x = angle % (2 * PiQ30);
+    if(x > PiQ30) x -= 2 * PiQ30;
+    else if(x < -PiQ30) x += 2 * PiQ30;
+
+    // sin(pi - x) = sin(x), x ends in [-pi / 2, pi / 2]
+    if(x > HalfPiQ30) x = PiQ30 - x;
+    else if(x < -HalfPiQ30) x = -PiQ30 - x;
+
+    const int64_t x2 = (x * x) >> 30;
+
+    int64_t series = OneQ30 - x2 / 110;
+    series = OneQ30 - ((x2 * series) >> 30) / 72;
+    series = OneQ30 - ((x2 * series) >> 30) / 42;
+    series = OneQ30 - ((x2 * series) >> 30) / 20;
+    series = OneQ30 - ((x2 * series) >> 30) / 6;
+    series = (x * series) >> 30;
+
+    return { static_cast<int32_t>((series + (1 << 13)) >> 14) };
+}
+
+constexpr Fixed16 Fixed16Sin(Fixed16 radians)
+{
+    return Fixed16SinQ30(int64_t(radians.raw) << 14);
+}
+
+constexpr Fixed16 Fixed16Cos(Fixed16 radians)
+{
+    // pi / 2 added before rounding to 16.16
+    return Fixed16SinQ30((int64_t(radians.raw) << 14) + 1686629713);
+}
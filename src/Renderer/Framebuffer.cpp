@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <cassert>
+
+#include "Renderer/Framebuffer.hpp"
+#include "Utils/CpuFeatures.hpp"
+
+namespace
+{
+    // Clips the rows of a textured span, rows clipped at the top still move v. False when nothing is left.
+    bool ClipTexturedSpan(const Framebuffer& framebuffer, uint32_t x, int32_t& yBegin, int32_t& yEnd, float& vBegin, float vStep, uint32_t texelsCount)
+    {
+        if(x >= framebuffer.width || texelsCount == 0) return false;
+
+        if(yBegin < 0)
+        {
+            vBegin -= vStep * yBegin;
+            yBegin = 0;
+        }
+
+        yEnd = std::min(yEnd, static_cast<int32_t>(framebuffer.height));
+
+        return yBegin < yEnd;
+    }
+
+    void ExpandPaletteIndicesScalar(const PaletteIndex* indices, const Color* colors, Color* destination, uint32_t count)
+    {
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            destination[i] = colors[indices[i]];
+        }
+    }
+
+#if defined(RAYCASTING_X86)
+    RAYCASTING_TARGET("avx2")
+    void ExpandPaletteIndicesAVX2(const PaletteIndex* indices, const Color* colors, Color* destination, uint32_t count)
+    {
+        const int* colorsInt = reinterpret_cast<const int*>(colors);
+        uint32_t i = 0;
+
+        for(; i + 8 <= count; i += 8)
+        {
+            const __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + i)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_i32gather_epi32(colorsInt, lanes, 4));
+        }
+
+        ExpandPaletteIndicesScalar(indices + i, colors, destination + i, count - i);
+    }
+#endif
+
+    // Color is 4 packed bytes, the AVX2 path gathers palette entries as 32 bit integers
+    static_assert(sizeof(Color) == 4);
+
+    // Transpose and palette expansion in one pass, tile by tile
+    void UploadPalettizedFramebuffer(const Framebuffer& framebuffer, Color* staging)
+    {
+        // "Palettized framebuffer without palette"
+        assert(framebuffer.palette != nullptr && framebuffer.palette->IsBuilt());
+
+        const uint32_t width = framebuffer.width;
+        const uint32_t height = framebuffer.height;
+        const Color* colors = framebuffer.palette->colors.data();
+
+        auto* expand = ExpandPaletteIndicesScalar;
+#if defined(RAYCASTING_X86)
+        if(GetSimdLevel() == SimdLevel::AVX2)
+        {
+            expand = ExpandPaletteIndicesAVX2;
+        }
+#endif
+
+        constexpr uint32_t TileSize = 32;
+        // Tile indices transposed to rows, a quarter of the size of a color tile
+        PaletteIndex tileRows[TileSize][TileSize];
+
+        // Row bands outside, the staging rows of a band are then written front to back
+        for(uint32_t tileY = 0; tileY < height; tileY += TileSize)
+        {
+            const uint32_t tileHeight = std::min(TileSize, height - tileY);
+
+            for(uint32_t tileX = 0; tileX < width; tileX += TileSize)
+            {
+                const uint32_t tileWidth = std::min(TileSize, width - tileX);
+
+                for(uint32_t x = 0; x < tileWidth; ++x)
+                {
+                    const PaletteIndex* column = framebuffer.IndexColumn(tileX + x) + tileY;
+
+                    for(uint32_t y = 0; y < tileHeight; ++y)
+                    {
+                        tileRows[y][x] = column[y];
+                    }
+                }
+
+                for(uint32_t y = 0; y < tileHeight; ++y)
+                {
+                    expand(tileRows[y], colors, staging + static_cast<size_t>(height - 1 - (tileY + y)) * width + tileX, tileWidth);
+                }
+            }
+        }
+    }
+}
+
+void ResizeFramebuffer(Framebuffer& framebuffer, uint32_t width, uint32_t height, FramebufferFormat format, const Palette* palette)
+{
+    framebuffer.width = width;
+    framebuffer.height = height;
+    framebuffer.format = format;
+    framebuffer.palette = palette;
+
+    // The buffer of the other format keeps its capacity, switching back does not allocate
+    const size_t pixelsCount = static_cast<size_t>(width) * height;
+    framebuffer.pixels.resize(format == FramebufferFormat::RGBA ? pixelsCount : 0);
+    framebuffer.indices.resize(format == FramebufferFormat::Palettized ? pixelsCount : 0);
+}
+
+void ClearFramebuffer(Framebuffer& framebuffer, Color color)
+{
+    switch(framebuffer.format)
+    {
+        case FramebufferFormat::RGBA:
+            std::fill(framebuffer.pixels.begin(), framebuffer.pixels.end(), color);
+        break;
+
+        case FramebufferFormat::Palettized:
+            std::fill(framebuffer.indices.begin(), framebuffer.indices.end(), FindPaletteIndex(*framebuffer.palette, color));
+        break;
+    }
+}
+
+void FillFramebufferColumn(Framebuffer& framebuffer, uint32_t x, int32_t yBegin, int32_t yEnd, Color color)
+{
+    if(framebuffer.format == FramebufferFormat::Palettized)
+    {
+        FillFramebufferColumnIndex(framebuffer, x, yBegin, yEnd, FindPaletteIndex(*framebuffer.palette, color));
+        return;
+    }
+
+    if(x >= framebuffer.width) return;
+
+    yBegin = std::max(yBegin, 0);
+    yEnd = std::min(yEnd, static_cast<int32_t>(framebuffer.height));
+
+    if(yBegin >= yEnd) return;
+
+    Color* column = framebuffer.Column(x);
+    std::fill(column + yBegin, column + yEnd, color);
+}
+
+void FillFramebufferColumnIndex(Framebuffer& framebuffer, uint32_t x, int32_t yBegin, int32_t yEnd, PaletteIndex index)
+{
+    if(x >= framebuffer.width) return;
+
+    yBegin = std::max(yBegin, 0);
+    yEnd = std::min(yEnd, static_cast<int32_t>(framebuffer.height));
+
+    if(yBegin >= yEnd) return;
+
+    PaletteIndex* column = framebuffer.IndexColumn(x);
+    std::fill(column + yBegin, column + yEnd, index);
+}
+
+void FillFramebufferColumnTextured(Framebuffer& framebuffer, uint32_t x, int32_t yBegin, int32_t yEnd,
+    const Color* texels, uint32_t texelsCount, float vBegin, float vStep, uint32_t light)
+{
+    if(!ClipTexturedSpan(framebuffer, x, yBegin, yEnd, vBegin, vStep, texelsCount)) return;
+
+    // 16.16 fixed point v, the inner loop is then integer only
+    int64_t v = static_cast<int64_t>(std::max(vBegin, 0.f) * 65536.f);
+    const int64_t step = static_cast<int64_t>(vStep * 65536.f);
+    const int64_t lastTexel = texelsCount - 1;
+
+    Color* pixel = framebuffer.Column(x) + yBegin;
+
+    for(int32_t y = yBegin; y < yEnd; ++y, v += step)
+    {
+        const Color texel = texels[std::min(v >> 16, lastTexel)];
+
+        *pixel++ = {
+            static_cast<uint8_t>((texel.r * light) >> 8),
+            static_cast<uint8_t>((texel.g * light) >> 8),
+            static_cast<uint8_t>((texel.b * light) >> 8),
+            255,
+        };
+    }
+}
+
+void FillFramebufferColumnTexturedIndex(Framebuffer& framebuffer, uint32_t x, int32_t yBegin, int32_t yEnd,
+    const PaletteIndex* texels, uint32_t texelsCount, float vBegin, float vStep, const PaletteIndex* shadeTable)
+{
+    if(!ClipTexturedSpan(framebuffer, x, yBegin, yEnd, vBegin, vStep, texelsCount)) return;
+
+    // Same v stepping as FillFramebufferColumnTextured
+    int64_t v = static_cast<int64_t>(std::max(vBegin, 0.f) * 65536.f);
+    const int64_t step = static_cast<int64_t>(vStep * 65536.f);
+    const int64_t lastTexel = texelsCount - 1;
+
+    PaletteIndex* pixel = framebuffer.IndexColumn(x) + yBegin;
+
+    for(int32_t y = yBegin; y < yEnd; ++y, v += step)
+    {
+        *pixel++ = shadeTable[texels[std::min(v >> 16, lastTexel)]];
+    }
+}
+
+void FillFramebufferRow(Framebuffer& framebuffer, uint32_t y, int32_t xBegin, int32_t xEnd, Color color)
+{
+    if(framebuffer.format == FramebufferFormat::Palettized)
+    {
+        FillFramebufferRowIndex(framebuffer, y, xBegin, xEnd, FindPaletteIndex(*framebuffer.palette, color));
+        return;
+    }
+
+    if(y >= framebuffer.height) return;
+
+    xBegin = std::max(xBegin, 0);
+    xEnd = std::min(xEnd, static_cast<int32_t>(framebuffer.width));
+
+    Color* pixel = framebuffer.pixels.data() + static_cast<size_t>(xBegin) * framebuffer.height + y;
+
+    for(int32_t x = xBegin; x < xEnd; ++x, pixel += framebuffer.height)
+    {
+        *pixel = color;
+    }
+}
+
+void FillFramebufferRowIndex(Framebuffer& framebuffer, uint32_t y, int32_t xBegin, int32_t xEnd, PaletteIndex index)
+{
+    if(y >= framebuffer.height) return;
+
+    xBegin = std::max(xBegin, 0);
+    xEnd = std::min(xEnd, static_cast<int32_t>(framebuffer.width));
+
+    PaletteIndex* pixel = framebuffer.indices.data() + static_cast<size_t>(xBegin) * framebuffer.height + y;
+
+    for(int32_t x = xBegin; x < xEnd; ++x, pixel += framebuffer.height)
+    {
+        *pixel = index;
+    }
+}
+
+void FillFramebufferRectangle(Framebuffer& framebuffer, int32_t posX, int32_t posY, int32_t width, int32_t height, Color color)
+{
+    const int32_t xBegin = std::max(posX, 0);
+    const int32_t xEnd = std::min(posX + width, static_cast<int32_t>(framebuffer.width));
+
+    for(int32_t x = xBegin; x < xEnd; ++x)
+    {
+        FillFramebufferColumn(framebuffer, x, posY, posY + height, color);
+    }
+}
+
+void UploadFramebuffer(Framebuffer& framebuffer, const Texture2D& texture)
+{
+    // "Framebuffer and texture sizes differ"
+    assert(framebuffer.width == static_cast<uint32_t>(texture.width) && framebuffer.height == static_cast<uint32_t>(texture.height));
+
+    const uint32_t width = framebuffer.width;
+    const uint32_t height = framebuffer.height;
+
+    framebuffer.uploadStaging.resize(static_cast<size_t>(width) * height);
+    Color* staging = framebuffer.uploadStaging.data();
+
+    if(framebuffer.format == FramebufferFormat::Palettized)
+    {
+        UploadPalettizedFramebuffer(framebuffer, staging);
+        UpdateTexture(texture, staging);
+        return;
+    }
+
+    // Transpose tile by tile so both the column reads and the row writes stay in cache
+    constexpr uint32_t TileSize = 32;
+
+    for(uint32_t tileX = 0; tileX < width; tileX += TileSize)
+    {
+        const uint32_t tileXEnd = std::min(tileX + TileSize, width);
+
+        for(uint32_t tileY = 0; tileY < height; tileY += TileSize)
+        {
+            const uint32_t tileYEnd = std::min(tileY + TileSize, height);
+
+            for(uint32_t x = tileX; x < tileXEnd; ++x)
+            {
+                const Color* column = framebuffer.Column(x);
+
+                for(uint32_t y = tileY; y < tileYEnd; ++y)
+                {
+                    staging[static_cast<size_t>(height - 1 - y) * width + x] = column[y];
+                }
+            }
+        }
+    }
+
+    UpdateTexture(texture, staging);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <raylib.h>
+#include <vector>
+#include <cstdint>
+
+#include "Renderer/Palette.hpp"
+
+enum class FramebufferFormat
+{
+    // One Color per pixel
+    RGBA,
+    // One PaletteIndex per pixel, expanded to colors by UploadFramebuffer
+    Palettized,
+};
+
+/// CPU render target written by the rasterizer framebuffer backend.
+/// Pixels are stored column-major (pixels[x * height + y]) because the rasterizer only ever writes
+/// vertical spans, a span is then one contiguous run of memory.
+/// Only the buffer of the current format is sized, the Color fills of a palettized framebuffer write
+/// the nearest palette entry.
+struct Framebuffer
+{
+    uint32_t width  { 0 };
+    uint32_t height { 0 };
+    FramebufferFormat format { FramebufferFormat::RGBA };
+    std::vector<Color> pixels;
+    // Palettized format, same layout as pixels
+    std::vector<PaletteIndex> indices;
+    const Palette* palette { nullptr };
+
+    // Row-major copy built by UploadFramebuffer, kept to not reallocate it every frame
+    std::vector<Color> uploadStaging;
+
+    Color* Column(uint32_t x) { return pixels.data() + static_cast<size_t>(x) * height; }
+    const Color* Column(uint32_t x) const { return pixels.data() + static_cast<size_t>(x) * height; }
+    PaletteIndex* IndexColumn(uint32_t x) { return indices.data() + static_cast<size_t>(x) * height; }
+    const PaletteIndex* IndexColumn(uint32_t x) const { return indices.data() + static_cast<size_t>(x) * height; }
+};
+
+/// @param palette must outlive the framebuffer use, Palettized format only
+void ResizeFramebuffer(Framebuffer& framebuffer, uint32_t width, uint32_t height,
+    FramebufferFormat format = FramebufferFormat::RGBA, const Palette* palette = nullptr);
+void ClearFramebuffer(Framebuffer& framebuffer, Color color);
+
+// Fills rows [yBegin, yEnd[ of column x, the span is clipped to the framebuffer
+void FillFramebufferColumn(Framebuffer& framebuffer, uint32_t x, int32_t yBegin, int32_t yEnd, Color color);
+// Palettized format only, same as FillFramebufferColumn with a palette entry
+void FillFramebufferColumnIndex(Framebuffer& framebuffer, uint32_t x, int32_t yBegin, int32_t yEnd, PaletteIndex index);
+// Fills rows [yBegin, yEnd[ of column x with texels, row yBegin reads texel vBegin and every next row moves
+// vStep texels further (clamped to the last one). Texel channels are scaled by light / 256.
+void FillFramebufferColumnTextured(Framebuffer& framebuffer, uint32_t x, int32_t yBegin, int32_t yEnd,
+    const Color* texels, uint32_t texelsCount, float vBegin, float vStep, uint32_t light);
+// Palettized format only, texels are palette entries already (see SetWallTextureCachePalette), shaded through shadeTable (one of Palette::shadeTables)
+void FillFramebufferColumnTexturedIndex(Framebuffer& framebuffer, uint32_t x, int32_t yBegin, int32_t yEnd,
+    const PaletteIndex* texels, uint32_t texelsCount, float vBegin, float vStep, const PaletteIndex* shadeTable);
+// Fills columns [xBegin, xEnd[ of row y, one pixel per column with the column-major layout
+void FillFramebufferRow(Framebuffer& framebuffer, uint32_t y, int32_t xBegin, int32_t xEnd, Color color);
+// Palettized format only, same as FillFramebufferRow with a palette entry
+void FillFramebufferRowIndex(Framebuffer& framebuffer, uint32_t y, int32_t xBegin, int32_t xEnd, PaletteIndex index);
+// Same clipping and pixel coverage as raylib DrawRectangle
+void FillFramebufferRectangle(Framebuffer& framebuffer, int32_t posX, int32_t posY, int32_t width, int32_t height, Color color);
+
+/// @brief Copies the framebuffer into texture with a single UpdateTexture call
+/// Rows are written bottom to top, texture is expected to be the color attachment of a RenderTexture,
+/// which every view of the editor displays Y flipped. Palettized pixels are expanded to colors in the same
+/// pass, eight at a time with AVX2.
+/// @param texture R8G8B8A8 texture of the same size as the framebuffer
+void UploadFramebuffer(Framebuffer& framebuffer, const Texture2D& texture);
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <cassert>
+
+#include "Renderer/Palette.hpp"
+#include "Utils/ColorHelper.hpp"
+
+namespace
+{
+    // Green weighs the most and blue the least, like the eye
+    uint32_t ColorDistance(Color a, Color b)
+    {
+        const int32_t r = a.r - b.r;
+        const int32_t g = a.g - b.g;
+        const int32_t bl = a.b - b.b;
+
+        return static_cast<uint32_t>(2 * r * r + 4 * g * g + 3 * bl * bl);
+    }
+
+    PaletteIndex FindNearestEntry(const Palette& palette, uint32_t colorsCount, Color color)
+    {
+        uint32_t bestIndex = 0;
+        uint32_t bestDistance = ColorDistance(palette.colors[0], color);
+
+        for(uint32_t i = 1; i < colorsCount && bestDistance != 0; ++i)
+        {
+            const uint32_t distance = ColorDistance(palette.colors[i], color);
+            if(distance < bestDistance)
+            {
+                bestIndex = i;
+                bestDistance = distance;
+            }
+        }
+
+        return static_cast<PaletteIndex>(bestIndex);
+    }
+
+    uint32_t Rgb555(Color color)
+    {
+        return ((color.r >> 3) << 10) | ((color.g >> 3) << 5) | (color.b >> 3);
+    }
+}
+
+void BuildPalette(Palette& palette, std::span<const Color> exactColors)
+{
+    uint32_t colorsCount = 0;
+
+    const auto hasColor = [&palette, &colorsCount](Color color)
+    {
+        const auto end = palette.colors.begin() + colorsCount;
+        return std::find_if(palette.colors.begin(), end, [color](Color entry) { return ColorDistance(entry, color) == 0; }) != end;
+    };
+
+    // Every shade of every color may be drawn, the exact colors past the cap are only approximated by them
+    std::vector<Color> shades;
+    shades.reserve(exactColors.size() * PaletteShadeLevels);
+
+    for(Color color : exactColors)
+    {
+        color.a = 255;
+
+        if(colorsCount < PaletteMaxExactColors && !hasColor(color))
+        {
+            palette.colors[colorsCount++] = color;
+        }
+
+        for(uint32_t level = 0; level < PaletteShadeLevels; ++level)
+        {
+            shades.push_back(ColorDarken(color, static_cast<float>(level) / (PaletteShadeLevels - 1)));
+        }
+    }
+
+    constexpr uint32_t CubeSize = PaletteCubeLevels * PaletteCubeLevels * PaletteCubeLevels;
+
+    // "The color cube does not fit next to the exact colors"
+    static_assert(PaletteMaxExactColors + CubeSize < PaletteSize);
+
+    const uint32_t exactColorsCount = colorsCount;
+
+    // Median cut of the shades, each box becomes the entry of its mean color
+    struct ShadeBox { uint32_t begin; uint32_t end; };
+    std::vector<ShadeBox> boxes;
+    if(!shades.empty())
+    {
+        boxes.push_back({ 0, static_cast<uint32_t>(shades.size()) });
+    }
+
+    const auto channelExtent = [&shades](ShadeBox box, uint8_t Color::* channel)
+    {
+        const auto [min, max] = std::minmax_element(shades.begin() + box.begin, shades.begin() + box.end,
+            [channel](Color a, Color b) { return a.*channel < b.*channel; });
+        return (*max).*channel - (*min).*channel;
+    };
+
+    while(boxes.size() < PaletteSize - exactColorsCount - CubeSize)
+    {
+        // Widest box first, green counts the most like in ColorDistance
+        uint32_t widestBox = 0;
+        int32_t widestExtent = 0;
+        uint8_t Color::* widestChannel = &Color::g;
+
+        for(uint32_t i = 0; i < boxes.size(); ++i)
+        {
+            for(auto [channel, weight] : { std::pair { &Color::r, 2 }, std::pair { &Color::g, 4 }, std::pair { &Color::b, 3 } })
+            {
+                const int32_t extent = channelExtent(boxes[i], channel) * weight;
+                if(extent > widestExtent)
+                {
+                    widestBox = i;
+                    widestExtent = extent;
+                    widestChannel = channel;
+                }
+            }
+        }
+
+        // Every box holds a single color
+        if(widestExtent == 0) break;
+
+        const ShadeBox box = boxes[widestBox];
+        const auto middle = shades.begin() + (box.begin + box.end) / 2;
+        std::nth_element(shades.begin() + box.begin, middle, shades.begin() + box.end,
+            [widestChannel](Color a, Color b) { return a.*widestChannel < b.*widestChannel; });
+
+        const auto split = static_cast<uint32_t>(middle - shades.begin());
+        boxes[widestBox] = { box.begin, split };
+        boxes.push_back({ split, box.end });
+    }
+
+    const auto addColor = [&palette, &colorsCount, &hasColor](Color color)
+    {
+        if(colorsCount < PaletteSize && !hasColor(color))
+        {
+            palette.colors[colorsCount++] = color;
+        }
+    };
+
+    for(ShadeBox box : boxes)
+    {
+        uint32_t r = 0, g = 0, b = 0;
+        for(uint32_t i = box.begin; i < box.end; ++i)
+        {
+            r += shades[i].r; g += shades[i].g; b += shades[i].b;
+        }
+
+        const uint32_t count = box.end - box.begin;
+        addColor({
+            static_cast<uint8_t>((r + count / 2) / count),
+            static_cast<uint8_t>((g + count / 2) / count),
+            static_cast<uint8_t>((b + count / 2) / count),
+            255
+        });
+    }
+
+    // Covers the texels and whatever else is far from the world colors
+    for(uint32_t r = 0; r < PaletteCubeLevels; ++r)
+    {
+        for(uint32_t g = 0; g < PaletteCubeLevels; ++g)
+        {
+            for(uint32_t b = 0; b < PaletteCubeLevels; ++b)
+            {
+                addColor({
+                    static_cast<uint8_t>(r * 255 / (PaletteCubeLevels - 1)),
+                    static_cast<uint8_t>(g * 255 / (PaletteCubeLevels - 1)),
+                    static_cast<uint8_t>(b * 255 / (PaletteCubeLevels - 1)),
+                    255
+                });
+            }
+        }
+    }
+
+    // Duplicates were skipped and few world colors leave boxes unused, the entries left go to grays
+    const uint32_t grayEntries = PaletteSize - colorsCount;
+    for(uint32_t i = 0; i < grayEntries; ++i)
+    {
+        const auto gray = static_cast<uint8_t>((i + 1) * 255 / (grayEntries + 1));
+        addColor({ gray, gray, gray, 255 });
+    }
+
+    // A gray already in the palette leaves its entry black
+    std::fill(palette.colors.begin() + colorsCount, palette.colors.end(), BLACK);
+
+    for(uint32_t level = 0; level < PaletteShadeLevels; ++level)
+    {
+        const float darkness = static_cast<float>(level) / (PaletteShadeLevels - 1);
+
+        for(uint32_t i = 0; i < PaletteSize; ++i)
+        {
+            palette.shadeTables[level][i] = FindNearestEntry(palette, colorsCount, ColorDarken(palette.colors[i], darkness));
+        }
+    }
+
+    palette.nearestIndices.resize(1 << 15);
+
+    for(uint32_t rgb = 0; rgb < (1 << 15); ++rgb)
+    {
+        // Center of the RGB555 cell
+        const Color color = {
+            static_cast<uint8_t>(((rgb >> 10) << 3) | 4),
+            static_cast<uint8_t>((((rgb >> 5) & 31) << 3) | 4),
+            static_cast<uint8_t>(((rgb & 31) << 3) | 4),
+            255
+        };
+
+        palette.nearestIndices[rgb] = FindNearestEntry(palette, colorsCount, color);
+    }
+
+    // The cell center may be closer to another entry, exact colors must find themselves
+    for(uint32_t i = 0; i < exactColorsCount; ++i)
+    {
+        palette.nearestIndices[Rgb555(palette.colors[i])] = static_cast<PaletteIndex>(i);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <raylib.h>
+#include <raymath.h>
+#include <array>
+#include <vector>
+#include <span>
+#include <cmath>
+#include <cstdint>
+
+constexpr uint32_t PaletteSize = 256;
+// Distance shading levels, level 0 leaves colors as they are and the last one turns them black
+constexpr uint32_t PaletteShadeLevels = 32;
+// Colors kept exact in the palette, the others are matched to the nearest entry
+constexpr uint32_t PaletteMaxExactColors = 64;
+// Levels per channel of the color cube the palette ends with, for the colors far from the world ones
+constexpr uint32_t PaletteCubeLevels = 4;
+
+using PaletteIndex = uint8_t;
+
+/// 256 colors and their shading tables, built once for the palettized framebuffer.
+/// Like the Doom COLORMAP, shadeTables[level][index] is the entry nearest to colors[index] darkened by
+/// level / (PaletteShadeLevels - 1), shading a palettized pixel is then a single lookup.
+struct Palette
+{
+    std::array<Color, PaletteSize> colors {};
+    std::array<std::array<PaletteIndex, PaletteSize>, PaletteShadeLevels> shadeTables {};
+    // Nearest entry of every RGB555 color, exact colors map to their own entry. Empty until built.
+    std::vector<PaletteIndex> nearestIndices;
+
+    bool IsBuilt() const { return !nearestIndices.empty(); }
+};
+
+/// @brief Fills palette with exactColors (the first PaletteMaxExactColors different ones), then the mean colors of a
+/// median cut of every shade level of every exact color, then a PaletteCubeLevels color cube. Entries left go to grays.
+void BuildPalette(Palette& palette, std::span<const Color> exactColors);
+
+inline PaletteIndex FindPaletteIndex(const Palette& palette, Color color)
+{
+    return palette.nearestIndices[((color.r >> 3) << 10) | ((color.g >> 3) << 5) | (color.b >> 3)];
+}
+
+// Shade level matching ColorDarken(color, normalizedDepth)
+inline uint32_t PaletteShadeLevel(float normalizedDepth)
+{
+    return static_cast<uint32_t>(roundf(Clamp(normalizedDepth, 0, 1) * (PaletteShadeLevels - 1)));
+}
@@ -0,0 +1,69 @@
+#include <cmath>
+#include <type_traits>
+
+#include "Renderer/ProjectionCache.hpp"
+#include "Renderer/RasterScalar.hpp"
+
+Vector2 ComputeColumnRayDirection(const RaycastingCamera& cam, uint32_t x, uint32_t renderTargetWidth)
+{
+    if constexpr(std::is_same_v<RasterScalar, float>)
+    {
+        const float rayAngle = RayAngleForScreenXCam(x, cam, renderTargetWidth);
+        return Vector2DirectionFromAngle((rayAngle * DEG2RAD) + cam.yaw);
+    }
+    else
+    {
+        // RayAngleForScreenXCam, fov * x is divided as a whole, a rounded fovRate drifts along the columns
+        const RasterScalar fov = ToRasterScalar<RasterScalar>(cam.fov);
+        const auto width = WideProduct(RasterScalarFromInt<RasterScalar>(renderTargetWidth), RasterScalarFromInt<RasterScalar>(1));
+        const RasterScalar rayAngle = -(fov / RasterScalarFromInt<RasterScalar>(2)) + WideQuotient(WideProduct(fov, RasterScalarFromInt<RasterScalar>(x)), width);
+
+        const RasterScalar radians = RasterRadians(rayAngle) + ToRasterScalar<RasterScalar>(cam.yaw);
+        return { RasterScalarToFloat(RasterCos(radians)), RasterScalarToFloat(RasterSin(radians)) };
+    }
+}
+
+float ComputeColumnRayCosine(const RaycastingCamera& cam, uint32_t x, uint32_t renderTargetWidth)
+{
+    if constexpr(std::is_same_v<RasterScalar, float>)
+    {
+        const float rayDirectionDeg = cam.fov * (floor(0.5 * renderTargetWidth) - x) / renderTargetWidth;
+        return cosf(rayDirectionDeg * DEG2RAD);
+    }
+    else
+    {
+        const RasterScalar columnsFromCenter = RasterScalarFromInt<RasterScalar>(renderTargetWidth / 2) - RasterScalarFromInt<RasterScalar>(x);
+        const auto width = WideProduct(RasterScalarFromInt<RasterScalar>(renderTargetWidth), RasterScalarFromInt<RasterScalar>(1));
+        const RasterScalar rayDirectionDeg = WideQuotient(WideProduct(ToRasterScalar<RasterScalar>(cam.fov), columnsFromCenter), width);
+        return RasterScalarToFloat(RasterCos(RasterRadians(rayDirectionDeg)));
+    }
+}
+
+bool UpdateProjectionCache(ProjectionCache& cache, const RaycastingCamera& cam, uint32_t renderTargetWidth)
+{
+    if(cache.valid 
+        && cache.fov == cam.fov 
+        && cache.fovVectical == cam.fovVectical 
+        && cache.yaw == cam.yaw 
+        && cache.renderTargetWidth == renderTargetWidth)
+    {
+        return false;
+    }
+
+    cache.fov = cam.fov;
+    cache.fovVectical = cam.fovVectical;
+    cache.yaw = cam.yaw;
+    cache.renderTargetWidth = renderTargetWidth;
+    cache.valid = true;
+
+    cache.rayDirections.resize(renderTargetWidth);
+    cache.rayCosines.resize(renderTargetWidth);
+
+    for(uint32_t x = 0; x < renderTargetWidth; ++x)
+    {
+        cache.rayDirections[x] = ComputeColumnRayDirection(cam, x, renderTargetWidth);
+        cache.rayCosines[x] = ComputeColumnRayCosine(cam, x, renderTargetWidth);
+    }
+
+    return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <raylib.h>
+#include <vector>
+#include <cstdint>
+
+#include "Renderer/RaycastingCamera.hpp"
+
+/// Per column camera terms, they only depend on the camera angles and the render target width
+/// so they are computed once instead of for every column of every sector visit.
+/// Each entry is computed with the exact expression it replaces, results are bit identical.
+struct ProjectionCache
+{
+    // Camera state the cache was built for
+    float fov         { 0 };
+    float fovVectical { 0 };
+    float yaw         { 0 };
+    uint32_t renderTargetWidth { 0 };
+    bool valid { false };
+
+    // Direction of the column ray, see ComputeColumnRay
+    std::vector<Vector2> rayDirections;
+    // Cosine of the column angle relative to the view axis, corrects the fisheye in ComputeCameraYAxis
+    std::vector<float> rayCosines;
+};
+
+/// @brief Direction of the ray of column x, computed with RasterScalar
+Vector2 ComputeColumnRayDirection(const RaycastingCamera& cam, uint32_t x, uint32_t renderTargetWidth);
+/// @brief Cosine of the column x angle relative to the view axis, computed with RasterScalar
+float ComputeColumnRayCosine(const RaycastingCamera& cam, uint32_t x, uint32_t renderTargetWidth);
+
+/// @brief Rebuilds the cache when one of the camera terms it depends on changed
+/// @return true when the cache was rebuilt
+bool UpdateProjectionCache(ProjectionCache& cache, const RaycastingCamera& cam, uint32_t renderTargetWidth);
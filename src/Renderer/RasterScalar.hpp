@@ -0,0 +1,95 @@
+#pragma once
+
+#include <raylib.h>
+#include <raymath.h>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#include "Renderer/FixedPoint.hpp"
+
+/// Scalar of the rasterizer geometry (ray / wall intersections, column rays, projection),
+/// float by default, 16.16 fixed point when built with RAYCASTING_FIXED_POINT.
+/// Fixed point frames are bit identical on every machine and compiler. World coordinates must then
+/// stay within about [-8192, 8192] so cross products of differences fit in Fixed16Wide.
+#if defined(RAYCASTING_FIXED_POINT)
+using RasterScalar = Fixed16;
+#else
+using RasterScalar = float;
+#endif
+
+// Rounding step of RasterScalar distances, the float ones are compared with a relative margin only
+constexpr float RasterDistanceTolerance = std::is_same_v<RasterScalar, float> ? 0.f : 4.f / Fixed16::One;
+
+// Relative margin of the coherent wall search early out. Hit distances come from the ray / segment intersection,
+// nearest distances from PointSegmentDistance in float: the two round differently by a few float ulps (~1e-7),
+// so a wall at the same distance could look farther and be skipped. 1e-4 keeps the early out conservative with
+// room to spare, lowering it can change which wall wins a column.
+constexpr float RasterDistanceRelativeMargin = 1.0001f;
+
+constexpr const char* RasterScalarName()
+{
+    return std::is_same_v<RasterScalar, float> ? "float" : "16.16 fixed point";
+}
+
+template<typename Scalar>
+struct RasterVector2
+{
+    Scalar x {};
+    Scalar y {};
+};
+
+// Operations the geometry code is written with, the float overloads are the plain expressions
+// so float results stay the ones of the code before the scalar became a parameter
+
+template<typename Scalar> constexpr Scalar ToRasterScalar(float value);
+template<> constexpr float ToRasterScalar<float>(float value) { return value; }
+template<> constexpr Fixed16 ToRasterScalar<Fixed16>(float value) { return Fixed16FromFloat(value); }
+
+template<typename Scalar> constexpr Scalar RasterScalarFromInt(uint32_t value);
+template<> constexpr float RasterScalarFromInt<float>(uint32_t value) { return static_cast<float>(value); }
+template<> constexpr Fixed16 RasterScalarFromInt<Fixed16>(uint32_t value) { return Fixed16FromInt(value); }
+
+constexpr float RasterScalarToFloat(float value) { return value; }
+constexpr float RasterScalarToFloat(Fixed16 value) { return Fixed16ToFloat(value); }
+
+template<typename Scalar>
+constexpr RasterVector2<Scalar> ToRasterVector2(Vector2 v)
+{
+    return { ToRasterScalar<Scalar>(v.x), ToRasterScalar<Scalar>(v.y) };
+}
+
+template<typename Scalar>
+constexpr Vector2 ToVector2(RasterVector2<Scalar> v)
+{
+    return { RasterScalarToFloat(v.x), RasterScalarToFloat(v.y) };
+}
+
+// Wide results are float for float, Fixed16Wide for Fixed16
+constexpr float WideProduct(float a, float b) { return a * b; }
+constexpr float WideQuotient(float numerator, float denominator) { return numerator / denominator; }
+inline float WideSqrt(float value) { return sqrtf(value); }
+constexpr float WideToFloat(float value) { return value; }
+
+inline float RasterRound(float value) { return roundf(value); }
+constexpr Fixed16 RasterRound(Fixed16 value) { return Fixed16Round(value); }
+
+inline float RasterRadians(float degrees) { return degrees * DEG2RAD; }
+constexpr Fixed16 RasterRadians(Fixed16 degrees) { return Fixed16Radians(degrees); }
+
+inline float RasterCos(float radians) { return cosf(radians); }
+constexpr Fixed16 RasterCos(Fixed16 radians) { return Fixed16Cos(radians); }
+
+inline float RasterSin(float radians) { return sinf(radians); }
+constexpr Fixed16 RasterSin(Fixed16 radians) { return Fixed16Sin(radians); }
+
+inline float RasterTan(float radians) { return tanf(radians); }
+constexpr Fixed16 RasterTan(Fixed16 radians) { return Fixed16Sin(radians) / Fixed16Cos(radians); }
+
+// Same as raymath Clamp, max wins when min > max
+template<typename Scalar>
+constexpr Scalar RasterClamp(Scalar value, Scalar min, Scalar max)
+{
+    const Scalar result = (value < min) ? min : value;
+    return (result > max) ? max : result;
+}
@@ -24,7 +24,8 @@ struct RaycastingCamera
     float nearPlaneDistance = 100.f;
     
     // Rendrer options
-    size_t maxRenderItr { 25 };
+    // Portals a column may cross, the frame stops at the same sectors whatever the rasterizer parallelism
+    size_t maxPortalDepth { 25 };
 
     // Player controller options
     float moveSpeed = 100.f;
@@ -48,6 +49,21 @@ struct RaycastingCamera
         };
     }
 
+    // True when both cameras render the same image, controller options are ignored
+    bool HasSameRenderState(const RaycastingCamera& other) const
+    {
+        return currentSectorId == other.currentSectorId
+            && position.x == other.position.x && position.y == other.position.y
+            && elevation == other.elevation
+            && yaw == other.yaw
+            && pitch == other.pitch
+            && fov == other.fov
+            && fovVectical == other.fovVectical
+            && farPlaneDistance == other.farPlaneDistance
+            && nearPlaneDistance == other.nearPlaneDistance
+            && maxPortalDepth == other.maxPortalDepth;
+    }
+
     void LookAt(float x, float y) { LookAt({x, y}); }
     void LookAt(const Vector2& positionLook)
     {
@@ -75,7 +91,7 @@ struct RaycastingCamera
             ImGui::SliderFloat("Z axis Move Speed", &zAxisMoveSpeed, 0, 5000);
             ImGui::SliderFloat("Mouse Sensitivity", &mouseSensitivity, 0, 2);
 
-            ImGui::InputInt("Max render itr", (int*)&maxRenderItr);
+            ImGui::InputInt("Max portal depth", (int*)&maxPortalDepth);
             ImGui::InputInt("Current Sector", (int*)&currentSectorId);
 
         ImGui::End();
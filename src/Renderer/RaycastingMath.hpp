@@ -10,6 +10,7 @@
 #include <cstdint>
 
 #include "Utils/ColorHelper.hpp"
+#include "Renderer/RasterScalar.hpp"
 
 inline Vector2 Vector2DirectionFromAngle(float angleRadian, float length = 1)
 {
@@ -32,11 +33,18 @@ struct Segment
 using SectorID = uint32_t;
 
 constexpr SectorID NULL_SECTOR { static_cast<SectorID>(-1) };
+
+// Index in World::wallTextures
+using WallTextureID = uint32_t;
+
+constexpr WallTextureID NULL_WALL_TEXTURE { static_cast<WallTextureID>(-1) };
 struct Wall
 {
     Segment segment;
     SectorID toSector = NULL_SECTOR;
     Color color = WHITE;
+    // Solid walls without texture are drawn with color
+    WallTextureID texture = NULL_WALL_TEXTURE;
 };
 
 struct Sector
@@ -73,41 +81,87 @@ struct HitInfo
     float distance = 0;
 };
 
-inline bool RayToSegmentCollision(const RasterRay& ray, const Segment& seg, HitInfo& hitInfo)
+/// @brief Ray / segment intersection computed with Scalar, see RasterScalar
+/// The float instantiation is the historical float code, its operations are kept in the same order.
+template<typename Scalar>
+bool RayToSegmentCollision(
+    RasterVector2<Scalar> rayPosition, RasterVector2<Scalar> rayDirection, RasterVector2<Scalar> a, RasterVector2<Scalar> b,
+    RasterVector2<Scalar>& outPosition, Scalar& outDistance)
 {
-    const float x1 = seg.a.x;
-    const float y1 = seg.a.y;
-    const float x2 = seg.b.x;
-    const float y2 = seg.b.y;
+    const Scalar x1 = a.x;
+    const Scalar y1 = a.y;
+    const Scalar x2 = b.x;
+    const Scalar y2 = b.y;
     
-    const float x3 = ray.position.x;
-    const float y3 = ray.position.y;
-    const float x4 = ray.position.x + ray.direction.x;
-    const float y4 = ray.position.y + ray.direction.y;
+    const Scalar x3 = rayPosition.x;
+    const Scalar y3 = rayPosition.y;
+    const Scalar x4 = rayPosition.x + rayDirection.x;
+    const Scalar y4 = rayPosition.y + rayDirection.y;
 
-    const float devider = (x1 - x2) * (y3 - y4) - (y1 - y2) * (x3 - x4);
+    const auto devider = WideProduct(x1 - x2, y3 - y4) - WideProduct(y1 - y2, x3 - x4);
 
     // the tow segements are perfectly parallels
-    if(devider == 0) return false;
+    if(devider == decltype(devider) {}) return false;
 
-    const float t = ((x1 - x3) * (y3 - y4) - (y1 - y3) * (x3 - x4)) / devider;
-    const float u = ((x1 - x3) * (y1 - y2) - (y1 - y3) * (x1 - x2)) / devider;
+    const Scalar t = WideQuotient(WideProduct(x1 - x3, y3 - y4) - WideProduct(y1 - y3, x3 - x4), devider);
+    const Scalar u = WideQuotient(WideProduct(x1 - x3, y1 - y2) - WideProduct(y1 - y3, x1 - x2), devider);
     
     // old wikipedia formula for u
     //const u = -((x1 - x2) * (y1 - y3) - (y1 - y2) * (x1 - x3)) / devider;
     
-    if(t > 0 && t < 1 && u > 0)
+    if(t > Scalar {} && t < ToRasterScalar<Scalar>(1) && u > Scalar {})
+    {
+        outPosition = { x1 + t * (x2 - x1), y1 + t * (y2 - y1) };
+
+        const Scalar dx = x3 - outPosition.x;
+        const Scalar dy = y3 - outPosition.y;
+        outDistance = WideSqrt(WideProduct(dx, dx) + WideProduct(dy, dy));
+
+        return true;
+    }
+
+    return false;
+}
+
+inline bool RayToSegmentCollision(const RasterRay& ray, const Segment& seg, HitInfo& hitInfo)
+{
+    RasterVector2<RasterScalar> hitPosition;
+    RasterScalar hitDistance;
+
+    if(!RayToSegmentCollision(
+        ToRasterVector2<RasterScalar>(ray.position), ToRasterVector2<RasterScalar>(ray.direction),
+        ToRasterVector2<RasterScalar>(seg.a), ToRasterVector2<RasterScalar>(seg.b),
+        hitPosition, hitDistance))
     {
-        const float xCollision = x1 + t * (x2 - x1);
-        const float yCollision = y1 + t * (y2 - y1);
+        return false;
+    }
+
+    hitInfo = {
+        .position = ToVector2(hitPosition),
+        .distance = RasterScalarToFloat(hitDistance)
+    };
+
+    return true;
+}
+
+// Intersection of the moving segment [from, to] with seg, outT is where along the move the crossing happens
+inline bool MoveToSegmentCollision(Vector2 from, Vector2 to, const Segment& seg, float& outT)
+{
+    const Vector2 move = Vector2Subtract(to, from);
+    const Vector2 wall = Vector2Subtract(seg.b, seg.a);
+
+    const float devider = move.x * wall.y - move.y * wall.x;
+
+    // the tow segements are perfectly parallels
+    if(devider == 0) return false;
 
-        const Vector2 hitPosition = { xCollision, yCollision };
-        
-        hitInfo  = {
-            .position = hitPosition,
-            .distance = Vector2Distance(ray.position, hitPosition)
-        };
+    const Vector2 fromToWall = Vector2Subtract(seg.a, from);
+    const float t = (fromToWall.x * wall.y - fromToWall.y * wall.x) / devider;
+    const float u = (fromToWall.x * move.y - fromToWall.y * move.x) / devider;
 
+    if(t >= 0 && t <= 1 && u >= 0 && u <= 1)
+    {
+        outT = t;
         return true;
     }
 
@@ -122,10 +176,27 @@ inline float RayAngleforScreenX(int screenX, float fov, int renderAreaWidth)
     return angle + (fovRate * screenX);
 }
 
+// Distance from point to the nearest point of the segment [a, b]
+inline float PointSegmentDistance(Vector2 point, Vector2 a, Vector2 b)
+{
+    const Vector2 ab = Vector2Subtract(b, a);
+    const float abLengthSqr = Vector2LengthSqr(ab);
+
+    const float t = (abLengthSqr > 0) ? Clamp(Vector2DotProduct(Vector2Subtract(point, a), ab) / abLengthSqr, 0.f, 1.f) : 0.f;
+
+    return Vector2Distance(point, Vector2Add(a, Vector2Scale(ab, t)));
+}
+
 // < 0 = right, 0 = on, > 0 = left
+template<typename Scalar>
+constexpr auto PointSegmentSide(RasterVector2<Scalar> point, RasterVector2<Scalar> a, RasterVector2<Scalar> b)
+{
+    return -(WideProduct(point.x - a.x, b.y - a.y) - WideProduct(point.y - a.y, b.x - a.x));
+}
+
 inline constexpr float PointSegmentSide(Vector2 point, Vector2 a, Vector2 b)
 {
-    return -(((point.x - a.x) * (b.y - a.y)) - ((point.y - a.y) * (b.x - a.x)));
+    return WideToFloat(PointSegmentSide(ToRasterVector2<RasterScalar>(point), ToRasterVector2<RasterScalar>(a), ToRasterVector2<RasterScalar>(b)));
 }
 
 inline Vector2 FindInsidePoint(const std::vector<Wall>& walls)
@@ -141,18 +212,21 @@ inline Vector2 FindInsidePoint(const std::vector<Wall>& walls)
     return insidePoint;
 }
 
-inline bool IsPointInSector(Vector2 point, const Sector& sector) 
+// Ray casting test step, true when the horizontal ray going right from point crosses the segment
+inline bool IsSegmentCrossedByPointRay(Vector2 point, Vector2 a, Vector2 b)
 {
-    const std::vector<Wall>& walls = sector.walls;
+    return (a.y > point.y) != (b.y > point.y) &&
+        (point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x);
+}
 
-    // Use the ray casting algorithm
+inline bool IsPointInSector(Vector2 point, const Sector& sector) 
+{
+    // Use the ray casting algorithm, every wall is an edge of the sector polygon
+    // so the walls order and orientation do not matter
     bool inside = false;
-    for (size_t i = 0, j = walls.size() - 1; i < walls.size(); j = i++) 
+    for (const Wall& wall : sector.walls) 
     {
-        Vector2 a = walls[i].segment.a;
-        Vector2 b = walls[j].segment.b;
-        if ((a.y > point.y) != (b.y > point.y) &&
-            (point.x < (b.x - a.x) * (point.y - a.y) / (b.y - a.y) + a.x))
+        if (IsSegmentCrossedByPointRay(point, wall.segment.a, wall.segment.b))
         {
             inside = !inside;
         }
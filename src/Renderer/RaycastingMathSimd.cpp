@@ -0,0 +1,419 @@
+#include "RaycastingMathSimd.hpp"
+
+#include <limits>
+#include <cassert>
+
+namespace
+{
+    // Reference implementation, also used when the CPU has no SIMD support
+    int32_t NearestHitScalar(const RasterRay& ray, const WallsSoAView& walls, HitInfo& bestHitInfo)
+    {
+        int32_t bestIndex = -1;
+        float bestDistance = std::numeric_limits<float>::max();
+
+        for(size_t i = 0; i < walls.count; ++i)
+        {
+            const Segment segment = { { walls.ax[i], walls.ay[i] }, { walls.bx[i], walls.by[i] } };
+
+            HitInfo hitInfo;
+            if(!RayToSegmentCollision(ray, segment, hitInfo))
+                continue;
+
+            if(walls.toSector[i] != static_cast<uint32_t>(-1) 
+                && PointSegmentSide(ray.position, segment.a, segment.b) <= 0)
+            {
+                continue;
+            }
+
+            if(bestDistance > hitInfo.distance)
+            {
+                bestDistance = hitInfo.distance;
+                bestIndex = static_cast<int32_t>(i);
+                bestHitInfo = hitInfo;
+            }
+        }
+
+        return bestIndex;
+    }
+
+    // Lanes keep the first nearest wall they saw, so on equal distances the lowest index wins like in the scalar loop
+    int32_t ReduceLanes(const float* distances, const int32_t* indices, size_t lanesCount)
+    {
+        int32_t bestIndex = -1;
+        float bestDistance = std::numeric_limits<float>::max();
+
+        for(size_t lane = 0; lane < lanesCount; ++lane)
+        {
+            if(indices[lane] < 0) continue;
+
+            if(distances[lane] < bestDistance 
+                || (distances[lane] == bestDistance && indices[lane] < bestIndex))
+            {
+                bestDistance = distances[lane];
+                bestIndex = indices[lane];
+            }
+        }
+
+        return bestIndex;
+    }
+
+    RasterRay PacketLaneRay(const RayPacket& packet, uint32_t lane)
+    {
+        return {
+            .position = packet.position,
+            .direction = { packet.directionX[lane], packet.directionY[lane] },
+        };
+    }
+
+    void PacketNearestHitsScalar(const RayPacket& packet, const WallsSoAView& walls, RayPacketHits& outHits)
+    {
+        for(uint32_t lane = 0; lane < packet.lanesCount; ++lane)
+        {
+            HitInfo hitInfo;
+            outHits.wallIndices[lane] = NearestHitScalar(PacketLaneRay(packet, lane), walls, hitInfo);
+            outHits.distances[lane] = hitInfo.distance;
+            outHits.positionsX[lane] = hitInfo.position.x;
+            outHits.positionsY[lane] = hitInfo.position.y;
+        }
+    }
+
+    // Backface rejection only depends on the packet origin, so it is done once per wall for all the lanes
+    bool IsBackfacingPortal(const WallsSoAView& walls, size_t i, Vector2 pointOfView)
+    {
+        return walls.toSector[i] != static_cast<uint32_t>(-1)
+            && PointSegmentSide(pointOfView, { walls.ax[i], walls.ay[i] }, { walls.bx[i], walls.by[i] }) <= 0;
+    }
+
+#if defined(RAYCASTING_X86)
+
+    // Operations are written in the same order as RayToSegmentCollision so every lane rounds like the scalar code.
+    // FMA is left out on purpose for the same reason.
+
+    RAYCASTING_TARGET("sse4.1")
+    int32_t NearestHitSSE4(const RasterRay& ray, const WallsSoAView& walls)
+    {
+        const float x3 = ray.position.x;
+        const float y3 = ray.position.y;
+        const float x4 = ray.position.x + ray.direction.x;
+        const float y4 = ray.position.y + ray.direction.y;
+
+        const __m128 vx3 = _mm_set1_ps(x3);
+        const __m128 vy3 = _mm_set1_ps(y3);
+        const __m128 vx34 = _mm_set1_ps(x3 - x4);
+        const __m128 vy34 = _mm_set1_ps(y3 - y4);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128i nullSector = _mm_set1_epi32(-1);
+
+        __m128 bestDistance = _mm_set1_ps(std::numeric_limits<float>::max());
+        __m128i bestIndex = _mm_set1_epi32(-1);
+        __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i indexStep = _mm_set1_epi32(4);
+
+        const size_t paddedCount = walls.paddedCount;
+
+        for(size_t i = 0; i < paddedCount; i += 4)
+        {
+            const __m128 x1 = _mm_loadu_ps(&walls.ax[i]);
+            const __m128 y1 = _mm_loadu_ps(&walls.ay[i]);
+            const __m128 x2 = _mm_loadu_ps(&walls.bx[i]);
+            const __m128 y2 = _mm_loadu_ps(&walls.by[i]);
+
+            const __m128 x12 = _mm_sub_ps(x1, x2);
+            const __m128 y12 = _mm_sub_ps(y1, y2);
+            const __m128 x13 = _mm_sub_ps(x1, vx3);
+            const __m128 y13 = _mm_sub_ps(y1, vy3);
+
+            const __m128 devider = _mm_sub_ps(_mm_mul_ps(x12, vy34), _mm_mul_ps(y12, vx34));
+            const __m128 t = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(x13, vy34), _mm_mul_ps(y13, vx34)), devider);
+            const __m128 u = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(x13, y12), _mm_mul_ps(y13, x12)), devider);
+
+            __m128 hitMask = _mm_cmpneq_ps(devider, zero);
+            hitMask = _mm_and_ps(hitMask, _mm_cmpgt_ps(t, zero));
+            hitMask = _mm_and_ps(hitMask, _mm_cmplt_ps(t, one));
+            hitMask = _mm_and_ps(hitMask, _mm_cmpgt_ps(u, zero));
+
+            const __m128 xCollision = _mm_add_ps(x1, _mm_mul_ps(t, _mm_sub_ps(x2, x1)));
+            const __m128 yCollision = _mm_add_ps(y1, _mm_mul_ps(t, _mm_sub_ps(y2, y1)));
+            const __m128 dx = _mm_sub_ps(vx3, xCollision);
+            const __m128 dy = _mm_sub_ps(vy3, yCollision);
+            const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+
+            // Portal backface rejection, see PointSegmentSide
+            const __m128 side = _mm_sub_ps(zero, _mm_sub_ps(
+                _mm_mul_ps(_mm_sub_ps(vx3, x1), _mm_sub_ps(y2, y1)), 
+                _mm_mul_ps(_mm_sub_ps(vy3, y1), _mm_sub_ps(x2, x1))));
+            const __m128i toSector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&walls.toSector[i]));
+            const __m128 isPortal = _mm_castsi128_ps(_mm_xor_si128(_mm_cmpeq_epi32(toSector, nullSector), _mm_set1_epi32(-1)));
+            const __m128 backface = _mm_and_ps(isPortal, _mm_cmple_ps(side, zero));
+
+            hitMask = _mm_andnot_ps(backface, hitMask);
+            hitMask = _mm_and_ps(hitMask, _mm_cmplt_ps(distance, bestDistance));
+
+            bestDistance = _mm_blendv_ps(bestDistance, distance, hitMask);
+            bestIndex = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(bestIndex), _mm_castsi128_ps(index), hitMask));
+            index = _mm_add_epi32(index, indexStep);
+        }
+
+        alignas(16) float distances[4];
+        alignas(16) int32_t indices[4];
+        _mm_store_ps(distances, bestDistance);
+        _mm_store_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+
+        return ReduceLanes(distances, indices, 4);
+    }
+
+    RAYCASTING_TARGET("avx2")
+    int32_t NearestHitAVX2(const RasterRay& ray, const WallsSoAView& walls)
+    {
+        const float x3 = ray.position.x;
+        const float y3 = ray.position.y;
+        const float x4 = ray.position.x + ray.direction.x;
+        const float y4 = ray.position.y + ray.direction.y;
+
+        const __m256 vx3 = _mm256_set1_ps(x3);
+        const __m256 vy3 = _mm256_set1_ps(y3);
+        const __m256 vx34 = _mm256_set1_ps(x3 - x4);
+        const __m256 vy34 = _mm256_set1_ps(y3 - y4);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.f);
+        const __m256i nullSector = _mm256_set1_epi32(-1);
+
+        __m256 bestDistance = _mm256_set1_ps(std::numeric_limits<float>::max());
+        __m256i bestIndex = _mm256_set1_epi32(-1);
+        __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i indexStep = _mm256_set1_epi32(8);
+
+        const size_t paddedCount = walls.paddedCount;
+
+        for(size_t i = 0; i < paddedCount; i += 8)
+        {
+            const __m256 x1 = _mm256_loadu_ps(&walls.ax[i]);
+            const __m256 y1 = _mm256_loadu_ps(&walls.ay[i]);
+            const __m256 x2 = _mm256_loadu_ps(&walls.bx[i]);
+            const __m256 y2 = _mm256_loadu_ps(&walls.by[i]);
+
+            const __m256 x12 = _mm256_sub_ps(x1, x2);
+            const __m256 y12 = _mm256_sub_ps(y1, y2);
+            const __m256 x13 = _mm256_sub_ps(x1, vx3);
+            const __m256 y13 = _mm256_sub_ps(y1, vy3);
+
+            const __m256 devider = _mm256_sub_ps(_mm256_mul_ps(x12, vy34), _mm256_mul_ps(y12, vx34));
+            const __m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(x13, vy34), _mm256_mul_ps(y13, vx34)), devider);
+            const __m256 u = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(x13, y12), _mm256_mul_ps(y13, x12)), devider);
+
+            __m256 hitMask = _mm256_cmp_ps(devider, zero, _CMP_NEQ_UQ);
+            hitMask = _mm256_and_ps(hitMask, _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+            hitMask = _mm256_and_ps(hitMask, _mm256_cmp_ps(t, one, _CMP_LT_OQ));
+            hitMask = _mm256_and_ps(hitMask, _mm256_cmp_ps(u, zero, _CMP_GT_OQ));
+
+            const __m256 xCollision = _mm256_add_ps(x1, _mm256_mul_ps(t, _mm256_sub_ps(x2, x1)));
+            const __m256 yCollision = _mm256_add_ps(y1, _mm256_mul_ps(t, _mm256_sub_ps(y2, y1)));
+            const __m256 dx = _mm256_sub_ps(vx3, xCollision);
+            const __m256 dy = _mm256_sub_ps(vy3, yCollision);
+            const __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+
+            // Portal backface rejection, see PointSegmentSide
+            const __m256 side = _mm256_sub_ps(zero, _mm256_sub_ps(
+                _mm256_mul_ps(_mm256_sub_ps(vx3, x1), _mm256_sub_ps(y2, y1)), 
+                _mm256_mul_ps(_mm256_sub_ps(vy3, y1), _mm256_sub_ps(x2, x1))));
+            const __m256i toSector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&walls.toSector[i]));
+            const __m256 isPortal = _mm256_castsi256_ps(_mm256_xor_si256(_mm256_cmpeq_epi32(toSector, nullSector), _mm256_set1_epi32(-1)));
+            const __m256 backface = _mm256_and_ps(isPortal, _mm256_cmp_ps(side, zero, _CMP_LE_OQ));
+
+            hitMask = _mm256_andnot_ps(backface, hitMask);
+            hitMask = _mm256_and_ps(hitMask, _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ));
+
+            bestDistance = _mm256_blendv_ps(bestDistance, distance, hitMask);
+            bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(index), hitMask));
+            index = _mm256_add_epi32(index, indexStep);
+        }
+
+        alignas(32) float distances[8];
+        alignas(32) int32_t indices[8];
+        _mm256_store_ps(distances, bestDistance);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(indices), bestIndex);
+
+        return ReduceLanes(distances, indices, 8);
+    }
+
+    // Packet kernels swap the roles: lanes are rays and each wall is broadcast to every lane
+
+    RAYCASTING_TARGET("sse4.1")
+    void PacketNearestHitsSSE4(const RayPacket& packet, const WallsSoAView& walls, RayPacketHits& outHits)
+    {
+        const __m128 vx3 = _mm_set1_ps(packet.position.x);
+        const __m128 vy3 = _mm_set1_ps(packet.position.y);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+
+        // An SSE register holds half a packet
+        for(uint32_t half = 0; half < RayPacketSize; half += 4)
+        {
+            if(half >= packet.lanesCount) break;
+
+            const __m128 vx4 = _mm_add_ps(vx3, _mm_load_ps(&packet.directionX[half]));
+            const __m128 vy4 = _mm_add_ps(vy3, _mm_load_ps(&packet.directionY[half]));
+            const __m128 vx34 = _mm_sub_ps(vx3, vx4);
+            const __m128 vy34 = _mm_sub_ps(vy3, vy4);
+
+            __m128 bestDistance = _mm_set1_ps(std::numeric_limits<float>::max());
+            __m128 bestX = zero;
+            __m128 bestY = zero;
+            __m128i bestIndex = _mm_set1_epi32(-1);
+
+            for(size_t i = 0; i < walls.count; ++i)
+            {
+                if(IsBackfacingPortal(walls, i, packet.position)) continue;
+
+                const __m128 x1 = _mm_set1_ps(walls.ax[i]);
+                const __m128 y1 = _mm_set1_ps(walls.ay[i]);
+                const __m128 x2 = _mm_set1_ps(walls.bx[i]);
+                const __m128 y2 = _mm_set1_ps(walls.by[i]);
+
+                const __m128 x12 = _mm_sub_ps(x1, x2);
+                const __m128 y12 = _mm_sub_ps(y1, y2);
+                const __m128 x13 = _mm_sub_ps(x1, vx3);
+                const __m128 y13 = _mm_sub_ps(y1, vy3);
+
+                const __m128 devider = _mm_sub_ps(_mm_mul_ps(x12, vy34), _mm_mul_ps(y12, vx34));
+                const __m128 t = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(x13, vy34), _mm_mul_ps(y13, vx34)), devider);
+                const __m128 u = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(x13, y12), _mm_mul_ps(y13, x12)), devider);
+
+                __m128 hitMask = _mm_cmpneq_ps(devider, zero);
+                hitMask = _mm_and_ps(hitMask, _mm_cmpgt_ps(t, zero));
+                hitMask = _mm_and_ps(hitMask, _mm_cmplt_ps(t, one));
+                hitMask = _mm_and_ps(hitMask, _mm_cmpgt_ps(u, zero));
+
+                if(_mm_movemask_ps(hitMask) == 0) continue;
+
+                const __m128 xCollision = _mm_add_ps(x1, _mm_mul_ps(t, _mm_sub_ps(x2, x1)));
+                const __m128 yCollision = _mm_add_ps(y1, _mm_mul_ps(t, _mm_sub_ps(y2, y1)));
+                const __m128 dx = _mm_sub_ps(vx3, xCollision);
+                const __m128 dy = _mm_sub_ps(vy3, yCollision);
+                const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+
+                hitMask = _mm_and_ps(hitMask, _mm_cmplt_ps(distance, bestDistance));
+
+                bestDistance = _mm_blendv_ps(bestDistance, distance, hitMask);
+                bestX = _mm_blendv_ps(bestX, xCollision, hitMask);
+                bestY = _mm_blendv_ps(bestY, yCollision, hitMask);
+                bestIndex = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(bestIndex), _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(i))), hitMask));
+            }
+
+            // Lanes past lanesCount hold rays of zero direction, writing them is harmless
+            _mm_store_si128(reinterpret_cast<__m128i*>(&outHits.wallIndices[half]), bestIndex);
+            _mm_store_ps(&outHits.distances[half], bestDistance);
+            _mm_store_ps(&outHits.positionsX[half], bestX);
+            _mm_store_ps(&outHits.positionsY[half], bestY);
+        }
+    }
+
+    RAYCASTING_TARGET("avx2")
+    void PacketNearestHitsAVX2(const RayPacket& packet, const WallsSoAView& walls, RayPacketHits& outHits)
+    {
+        const __m256 vx3 = _mm256_set1_ps(packet.position.x);
+        const __m256 vy3 = _mm256_set1_ps(packet.position.y);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.f);
+
+        const __m256 vx4 = _mm256_add_ps(vx3, _mm256_load_ps(packet.directionX));
+        const __m256 vy4 = _mm256_add_ps(vy3, _mm256_load_ps(packet.directionY));
+        const __m256 vx34 = _mm256_sub_ps(vx3, vx4);
+        const __m256 vy34 = _mm256_sub_ps(vy3, vy4);
+
+        __m256 bestDistance = _mm256_set1_ps(std::numeric_limits<float>::max());
+        __m256 bestX = zero;
+        __m256 bestY = zero;
+        __m256i bestIndex = _mm256_set1_epi32(-1);
+
+        for(size_t i = 0; i < walls.count; ++i)
+        {
+            if(IsBackfacingPortal(walls, i, packet.position)) continue;
+
+            const __m256 x1 = _mm256_set1_ps(walls.ax[i]);
+            const __m256 y1 = _mm256_set1_ps(walls.ay[i]);
+            const __m256 x2 = _mm256_set1_ps(walls.bx[i]);
+            const __m256 y2 = _mm256_set1_ps(walls.by[i]);
+
+            const __m256 x12 = _mm256_sub_ps(x1, x2);
+            const __m256 y12 = _mm256_sub_ps(y1, y2);
+            const __m256 x13 = _mm256_sub_ps(x1, vx3);
+            const __m256 y13 = _mm256_sub_ps(y1, vy3);
+
+            const __m256 devider = _mm256_sub_ps(_mm256_mul_ps(x12, vy34), _mm256_mul_ps(y12, vx34));
+            const __m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(x13, vy34), _mm256_mul_ps(y13, vx34)), devider);
+            const __m256 u = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(x13, y12), _mm256_mul_ps(y13, x12)), devider);
+
+            __m256 hitMask = _mm256_cmp_ps(devider, zero, _CMP_NEQ_UQ);
+            hitMask = _mm256_and_ps(hitMask, _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+            hitMask = _mm256_and_ps(hitMask, _mm256_cmp_ps(t, one, _CMP_LT_OQ));
+            hitMask = _mm256_and_ps(hitMask, _mm256_cmp_ps(u, zero, _CMP_GT_OQ));
+
+            // No lane crosses this wall, the whole packet moves on
+            if(_mm256_movemask_ps(hitMask) == 0) continue;
+
+            const __m256 xCollision = _mm256_add_ps(x1, _mm256_mul_ps(t, _mm256_sub_ps(x2, x1)));
+            const __m256 yCollision = _mm256_add_ps(y1, _mm256_mul_ps(t, _mm256_sub_ps(y2, y1)));
+            const __m256 dx = _mm256_sub_ps(vx3, xCollision);
+            const __m256 dy = _mm256_sub_ps(vy3, yCollision);
+            const __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+
+            hitMask = _mm256_and_ps(hitMask, _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ));
+
+            bestDistance = _mm256_blendv_ps(bestDistance, distance, hitMask);
+            bestX = _mm256_blendv_ps(bestX, xCollision, hitMask);
+            bestY = _mm256_blendv_ps(bestY, yCollision, hitMask);
+            bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex), _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int32_t>(i))), hitMask));
+        }
+
+        // Lanes past lanesCount hold rays of zero direction, writing them is harmless
+        _mm256_store_si256(reinterpret_cast<__m256i*>(outHits.wallIndices), bestIndex);
+        _mm256_store_ps(outHits.distances, bestDistance);
+        _mm256_store_ps(outHits.positionsX, bestX);
+        _mm256_store_ps(outHits.positionsY, bestY);
+    }
+
+#endif
+}
+
+int32_t RayToWallsNearestHit(const RasterRay& ray, const WallsSoAView& walls, HitInfo& hitInfo, SimdLevel level)
+{
+    int32_t wallIndex = -1;
+
+    switch(level)
+    {
+#if defined(RAYCASTING_X86)
+        case SimdLevel::AVX2: wallIndex = NearestHitAVX2(ray, walls); break;
+        case SimdLevel::SSE4: wallIndex = NearestHitSSE4(ray, walls); break;
+#endif
+        // The scalar search already holds the hit of its winner
+        default: return NearestHitScalar(ray, walls, hitInfo);
+    }
+
+    if(wallIndex < 0) return -1;
+
+    // Only the winner gets its hit recomputed, the scalar path yields the exact same values the lanes compared
+    const Segment segment = { 
+        { walls.ax[wallIndex], walls.ay[wallIndex] }, 
+        { walls.bx[wallIndex], walls.by[wallIndex] } 
+    };
+    RayToSegmentCollision(ray, segment, hitInfo);
+
+    return wallIndex;
+}
+
+void RayPacketToWallsNearestHits(const RayPacket& packet, const WallsSoAView& walls, RayPacketHits& outHits, SimdLevel level)
+{
+    // "A packet can not hold more than RayPacketSize rays"
+    assert(packet.lanesCount <= RayPacketSize);
+
+    switch(level)
+    {
+#if defined(RAYCASTING_X86)
+        case SimdLevel::AVX2: PacketNearestHitsAVX2(packet, walls, outHits); break;
+        case SimdLevel::SSE4: PacketNearestHitsSSE4(packet, walls, outHits); break;
+#endif
+        default: PacketNearestHitsScalar(packet, walls, outHits); break;
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "Renderer/RaycastingMath.hpp"
+#include "Utils/CpuFeatures.hpp"
+
+constexpr size_t WallsBatchSize = 8;
+
+// The lanes compare float hits, fixed point builds keep the scalar path which follows RasterScalar
+inline SimdLevel GetRasterSimdLevel()
+{
+    return std::is_same_v<RasterScalar, float> ? GetSimdLevel() : SimdLevel::Scalar;
+}
+
+inline size_t PaddedWallsCount(size_t wallsCount)
+{
+    return ((wallsCount + WallsBatchSize - 1) / WallsBatchSize) * WallsBatchSize;
+}
+
+// Walls geometry as separate arrays, padded with zero length walls up to a multiple of WallsBatchSize
+struct WallsSoAView
+{
+    const float* ax { nullptr };
+    const float* ay { nullptr };
+    const float* bx { nullptr };
+    const float* by { nullptr };
+    // Portal destination, -1 for solid walls
+    const uint32_t* toSector { nullptr };
+
+    // Walls count without the padding
+    size_t count { 0 };
+    size_t paddedCount { 0 };
+};
+
+/// @brief Nearest wall hit of one ray against every wall of a WallsSoAView, walls are tested a batch at a time
+/// @param ray ray to test, its position is also the point of view used to reject portals seen from behind
+/// @param walls sector walls, see RenderWorld::SectorWalls
+/// @param hitInfo filled with the nearest hit when there is one
+/// @param level instruction set to use, defaults to the best one supported by the CPU, see GetRasterSimdLevel
+/// @return index of the nearest hit wall in the view, -1 when nothing is hit
+/// Gives the same result as testing every wall with RayToSegmentCollision and keeping the first nearest.
+int32_t RayToWallsNearestHit(const RasterRay& ray, const WallsSoAView& walls, HitInfo& hitInfo, SimdLevel level = GetRasterSimdLevel());
+
+constexpr uint32_t RayPacketSize = 8;
+
+// Rays sharing the same origin, one per lane
+struct RayPacket
+{
+    Vector2 position { 0 };
+    alignas(32) float directionX[RayPacketSize] {};
+    alignas(32) float directionY[RayPacketSize] {};
+    // Only the first lanesCount lanes hold a ray
+    uint32_t lanesCount = 0;
+};
+
+// Nearest hit of each lane of a RayPacket
+struct RayPacketHits
+{
+    // Index of the hit wall in the view, -1 when the lane hit nothing
+    alignas(32) int32_t wallIndices[RayPacketSize];
+    alignas(32) float distances[RayPacketSize];
+    alignas(32) float positionsX[RayPacketSize];
+    alignas(32) float positionsY[RayPacketSize];
+};
+
+/// @brief Nearest wall hit of every ray of a packet, each wall is loaded once and tested against all the lanes
+/// @param packet rays to test, their origin is also the point of view used to reject portals seen from behind
+/// @param walls sector walls, see RenderWorld::SectorWalls
+/// @param outHits per lane nearest hit, only the first packet.lanesCount lanes are written
+/// @param level instruction set to use, defaults to the best one supported by the CPU, see GetRasterSimdLevel
+/// Each lane gets the same wall and hit RayToWallsNearestHit would give for its ray.
+void RayPacketToWallsNearestHits(const RayPacket& packet, const WallsSoAView& walls, RayPacketHits& outHits, SimdLevel level = GetRasterSimdLevel());
@@ -0,0 +1,399 @@
+#include "RenderWorld.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include "Renderer/World.hpp"
+
+namespace
+{
+    constexpr uint32_t WallBvhLeafSize = 4;
+    constexpr uint32_t WallBvhMaxDepth = 64;
+
+    Vector2 WallCentroid(const RenderWorld& renderWorld, WallIndex wallIndex)
+    {
+        return {
+            0.5f * (renderWorld.wallAx[wallIndex] + renderWorld.wallBx[wallIndex]),
+            0.5f * (renderWorld.wallAy[wallIndex] + renderWorld.wallBy[wallIndex]),
+        };
+    }
+
+    // Median split on the longest centroid axis, down to WallBvhLeafSize walls per leaf
+    void BuildSectorWallBvh(RenderWorld& renderWorld, SectorIndex sectorIndex)
+    {
+        RenderSector& sector = renderWorld.sectors[sectorIndex];
+
+        const uint32_t firstWall = static_cast<uint32_t>(renderWorld.wallBvhWalls.size());
+        for(WallIndex wallIndex = sector.wallsBegin; wallIndex < sector.wallsBegin + sector.wallsCount; ++wallIndex)
+        {
+            renderWorld.wallBvhWalls.push_back(wallIndex);
+        }
+
+        sector.wallBvhRoot = static_cast<uint32_t>(renderWorld.wallBvhNodes.size());
+        renderWorld.wallBvhNodes.push_back({ .first = firstWall, .wallsCount = sector.wallsCount });
+
+        std::vector<uint32_t> pendingNodes = { sector.wallBvhRoot };
+
+        while(!pendingNodes.empty())
+        {
+            const uint32_t nodeIndex = pendingNodes.back();
+            pendingNodes.pop_back();
+
+            const uint32_t first = renderWorld.wallBvhNodes[nodeIndex].first;
+            const uint32_t wallsCount = renderWorld.wallBvhNodes[nodeIndex].wallsCount;
+            const auto walls = renderWorld.wallBvhWalls.begin() + first;
+
+            Vector2 min = { INFINITY, INFINITY };
+            Vector2 max = { -INFINITY, -INFINITY };
+            Vector2 centroidMin = min;
+            Vector2 centroidMax = max;
+
+            for(uint32_t i = 0; i < wallsCount; ++i)
+            {
+                const Segment segment = renderWorld.WallSegment(walls[i]);
+                min = Vector2Min(min, Vector2Min(segment.a, segment.b));
+                max = Vector2Max(max, Vector2Max(segment.a, segment.b));
+
+                const Vector2 centroid = WallCentroid(renderWorld, walls[i]);
+                centroidMin = Vector2Min(centroidMin, centroid);
+                centroidMax = Vector2Max(centroidMax, centroid);
+            }
+
+            // Hit positions are rounded, a slightly bigger box can't miss them
+            const float margin = 1e-4f * std::max(max.x - min.x, max.y - min.y) + 1e-3f;
+            renderWorld.wallBvhNodes[nodeIndex].min = { min.x - margin, min.y - margin };
+            renderWorld.wallBvhNodes[nodeIndex].max = { max.x + margin, max.y + margin };
+
+            if(wallsCount <= WallBvhLeafSize) continue;
+
+            const bool splitOnX = (centroidMax.x - centroidMin.x) >= (centroidMax.y - centroidMin.y);
+            const uint32_t leftCount = wallsCount / 2;
+
+            // Ties on the wall index keep the tree the same from one compilation to the next
+            std::nth_element(walls, walls + leftCount, walls + wallsCount, [&renderWorld, splitOnX](WallIndex a, WallIndex b)
+            {
+                const Vector2 centroidA = WallCentroid(renderWorld, a);
+                const Vector2 centroidB = WallCentroid(renderWorld, b);
+                const float keyA = splitOnX ? centroidA.x : centroidA.y;
+                const float keyB = splitOnX ? centroidB.x : centroidB.y;
+
+                return keyA < keyB || (keyA == keyB && a < b);
+            });
+
+            const uint32_t children = static_cast<uint32_t>(renderWorld.wallBvhNodes.size());
+            renderWorld.wallBvhNodes.push_back({ .first = first, .wallsCount = leftCount });
+            renderWorld.wallBvhNodes.push_back({ .first = first + leftCount, .wallsCount = wallsCount - leftCount });
+
+            renderWorld.wallBvhNodes[nodeIndex].first = children;
+            renderWorld.wallBvhNodes[nodeIndex].wallsCount = 0;
+
+            pendingNodes.push_back(children);
+            pendingNodes.push_back(children + 1);
+        }
+    }
+
+    // Distance along the ray where it enters the box, false when the ray misses it
+    bool RayToBoxEntry(const RasterRay& ray, const WallBvhNode& node, float& outEntry)
+    {
+        float tMin = 0;
+        float tMax = INFINITY;
+
+        const float origins[2] = { ray.position.x, ray.position.y };
+        const float directions[2] = { ray.direction.x, ray.direction.y };
+        const float mins[2] = { node.min.x, node.min.y };
+        const float maxs[2] = { node.max.x, node.max.y };
+
+        for(int axis = 0; axis < 2; ++axis)
+        {
+            if(directions[axis] == 0)
+            {
+                if(origins[axis] < mins[axis] || origins[axis] > maxs[axis]) return false;
+                continue;
+            }
+
+            float t0 = (mins[axis] - origins[axis]) / directions[axis];
+            float t1 = (maxs[axis] - origins[axis]) / directions[axis];
+            if(t0 > t1) std::swap(t0, t1);
+
+            tMin = std::max(tMin, t0);
+            tMax = std::min(tMax, t1);
+        }
+
+        outEntry = tMin;
+        return tMin <= tMax;
+    }
+
+    // True when compiling world would give renderWorld the same sectors, wall segments and portals,
+    // the potentially visible sets only depend on those. Heights, colors and textures may differ.
+    bool IsSameSectorsLayout(const World& world, const RenderWorld& renderWorld)
+    {
+        if(world.Sectors.size() != renderWorld.sectors.size()) return false;
+
+        for(const auto& [ sectorId, sector ] : world.Sectors)
+        {
+            const SectorIndex sectorIndex = renderWorld.FindSectorIndex(sectorId);
+            if(sectorIndex == NULL_SECTOR_INDEX || renderWorld.sectors[sectorIndex].wallsCount != sector.walls.size()) return false;
+
+            const WallIndex wallsBegin = renderWorld.sectors[sectorIndex].wallsBegin;
+
+            for(size_t i = 0; i < sector.walls.size(); ++i)
+            {
+                const Wall& wall = sector.walls[i];
+                const WallIndex wallIndex = wallsBegin + static_cast<WallIndex>(i);
+                const SectorIndex toSector = (wall.toSector != NULL_SECTOR) ? renderWorld.FindSectorIndex(wall.toSector) : NULL_SECTOR_INDEX;
+
+                if(renderWorld.wallAx[wallIndex] != wall.segment.a.x || renderWorld.wallAy[wallIndex] != wall.segment.a.y
+                    || renderWorld.wallBx[wallIndex] != wall.segment.b.x || renderWorld.wallBy[wallIndex] != wall.segment.b.y
+                    || renderWorld.wallToSector[wallIndex] != toSector)
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+}
+
+void CompileRenderWorld(const World& world, RenderWorld& renderWorld)
+{
+    // Height, color or texture edits keep the sets, or the build of them in progress
+    const bool isSameLayout = IsSameSectorsLayout(world, renderWorld);
+
+    renderWorld.sectors.clear();
+    renderWorld.sectorColors.clear();
+    renderWorld.sectorIds.clear();
+    renderWorld.wallAx.clear();
+    renderWorld.wallAy.clear();
+    renderWorld.wallBx.clear();
+    renderWorld.wallBy.clear();
+    renderWorld.wallToSector.clear();
+    renderWorld.wallColors.clear();
+    renderWorld.wallTextures.clear();
+    renderWorld.sectorTexturesBegin.clear();
+    renderWorld.sectorTextures.clear();
+    renderWorld.wallBvhNodes.clear();
+    renderWorld.wallBvhWalls.clear();
+    renderWorld.sectorIndices.clear();
+
+    // Sorted ids give the same layout whatever the unordered_map iteration order is
+    for(const auto& [ sectorId, sector ] : world.Sectors)
+    {
+        renderWorld.sectorIds.push_back(sectorId);
+    }
+
+    std::sort(renderWorld.sectorIds.begin(), renderWorld.sectorIds.end());
+
+    for(SectorIndex i = 0; i < renderWorld.sectorIds.size(); ++i)
+    {
+        renderWorld.sectorIndices.emplace(renderWorld.sectorIds[i], i);
+    }
+
+    size_t wallsSize = 0;
+    for(const auto& [ sectorId, sector ] : world.Sectors)
+    {
+        wallsSize += PaddedWallsCount(sector.walls.size());
+    }
+
+    // Padding walls are zero length, the kernels reject them as parallel to every ray
+    renderWorld.wallAx.resize(wallsSize, 0.f);
+    renderWorld.wallAy.resize(wallsSize, 0.f);
+    renderWorld.wallBx.resize(wallsSize, 0.f);
+    renderWorld.wallBy.resize(wallsSize, 0.f);
+    renderWorld.wallToSector.resize(wallsSize, NULL_SECTOR_INDEX);
+    renderWorld.wallColors.resize(wallsSize, BLANK);
+    renderWorld.wallTextures.resize(wallsSize, NULL_WALL_TEXTURE);
+    renderWorld.texturesCount = static_cast<uint32_t>(world.wallTextures.size());
+    renderWorld.sectorTexturesBegin.reserve(renderWorld.sectorIds.size() + 1);
+
+    renderWorld.sectors.reserve(renderWorld.sectorIds.size());
+    renderWorld.sectorColors.reserve(renderWorld.sectorIds.size());
+
+    WallIndex wallsBegin = 0;
+
+    for(SectorID sectorId : renderWorld.sectorIds)
+    {
+        const Sector& sector = world.Sectors.at(sectorId);
+
+        renderWorld.sectors.push_back({
+            .wallsBegin = wallsBegin,
+            .wallsCount = static_cast<uint32_t>(sector.walls.size()),
+            .zCeiling = sector.zCeiling,
+            .zFloor = sector.zFloor,
+        });
+
+        renderWorld.sectorColors.push_back({
+            .floor = sector.floorColor,
+            .ceiling = sector.ceilingColor,
+            .topBorder = sector.topBorderColor,
+            .bottomBorder = sector.bottomBorderColor,
+        });
+
+        const auto sectorTexturesBegin = static_cast<uint32_t>(renderWorld.sectorTextures.size());
+        renderWorld.sectorTexturesBegin.push_back(sectorTexturesBegin);
+
+        for(size_t i = 0; i < sector.walls.size(); ++i)
+        {
+            const Wall& wall = sector.walls[i];
+            const WallIndex wallIndex = wallsBegin + static_cast<WallIndex>(i);
+
+            renderWorld.wallAx[wallIndex] = wall.segment.a.x;
+            renderWorld.wallAy[wallIndex] = wall.segment.a.y;
+            renderWorld.wallBx[wallIndex] = wall.segment.b.x;
+            renderWorld.wallBy[wallIndex] = wall.segment.b.y;
+            renderWorld.wallColors[wallIndex] = wall.color;
+            renderWorld.wallTextures[wallIndex] = wall.texture;
+
+            if(wall.toSector != NULL_SECTOR)
+            {
+                // "Portal to an invalid SectorID"
+                assert(renderWorld.sectorIndices.contains(wall.toSector));
+
+                // Portals to a missing sector are rendered as solid walls
+                renderWorld.wallToSector[wallIndex] = renderWorld.FindSectorIndex(wall.toSector);
+            }
+
+            // Only walls drawn solid show their texture
+            const auto sectorTexturesEnd = renderWorld.sectorTextures.end();
+            if(wall.texture < renderWorld.texturesCount && renderWorld.wallToSector[wallIndex] == NULL_SECTOR_INDEX
+                && std::find(renderWorld.sectorTextures.begin() + sectorTexturesBegin, sectorTexturesEnd, wall.texture) == sectorTexturesEnd)
+            {
+                renderWorld.sectorTextures.push_back(wall.texture);
+            }
+        }
+
+        wallsBegin += static_cast<WallIndex>(PaddedWallsCount(sector.walls.size()));
+    }
+
+    renderWorld.sectorTexturesBegin.push_back(static_cast<uint32_t>(renderWorld.sectorTextures.size()));
+
+    for(SectorIndex sectorIndex = 0; sectorIndex < renderWorld.sectors.size(); ++sectorIndex)
+    {
+        if(renderWorld.sectors[sectorIndex].wallsCount >= WallBvhMinWallsCount)
+        {
+            BuildSectorWallBvh(renderWorld, sectorIndex);
+        }
+    }
+
+    if(!isSameLayout)
+    {
+        renderWorld.sectorsPvs.clear();
+        renderWorld.pvsWordsPerSector = 0;
+        ++renderWorld.layoutRevision;
+    }
+}
+
+WallIndex RayToSectorWallBvhNearestHit(const RenderWorld& renderWorld, SectorIndex sectorIndex, SectorIndex viewSectorIndex, const RasterRay& ray, HitInfo& hitInfo)
+{
+    const uint32_t root = renderWorld.sectors[sectorIndex].wallBvhRoot;
+
+    // "RayToSectorWallBvhNearestHit on a sector without wall BVH"
+    assert(root != NULL_WALL_BVH_NODE);
+
+    // RayToSegmentCollision sees the ray in RasterScalar with the direction rounded through position + direction,
+    // far hits drift off the exact ray by more than the box margin unless the boxes are tested on that same line
+    const auto rasterPosition = ToRasterVector2<RasterScalar>(ray.position);
+    const auto rasterDirection = ToRasterVector2<RasterScalar>(ray.direction);
+
+    const RasterRay boxRay = {
+        .position = ToVector2(rasterPosition),
+        .direction = ToVector2(RasterVector2<RasterScalar> {
+            (rasterPosition.x + rasterDirection.x) - rasterPosition.x,
+            (rasterPosition.y + rasterDirection.y) - rasterPosition.y,
+        }),
+    };
+
+    // Box entries are along the ray direction, hits are distances
+    const float directionLength = Vector2Length(boxRay.direction);
+
+    WallIndex bestWallIndex = NULL_WALL_INDEX;
+    float bestDistance = std::numeric_limits<float>::max();
+
+    struct PendingNode
+    {
+        uint32_t nodeIndex;
+        float entryDistance;
+    };
+
+    PendingNode pendingNodes[WallBvhMaxDepth + 1];
+    uint32_t pendingNodesCount = 0;
+
+    float rootEntry;
+    if(RayToBoxEntry(boxRay, renderWorld.wallBvhNodes[root], rootEntry))
+    {
+        pendingNodes[pendingNodesCount++] = { root, rootEntry * directionLength };
+    }
+
+    while(pendingNodesCount > 0)
+    {
+        const PendingNode pendingNode = pendingNodes[--pendingNodesCount];
+
+        // A wall at the same distance with a lower index would still win, so only strictly farther boxes are skipped
+        if(pendingNode.entryDistance > bestDistance) continue;
+
+        const WallBvhNode& node = renderWorld.wallBvhNodes[pendingNode.nodeIndex];
+
+        if(node.wallsCount > 0)
+        {
+            for(uint32_t i = node.first; i < node.first + node.wallsCount; ++i)
+            {
+                const WallIndex wallIndex = renderWorld.wallBvhWalls[i];
+                const Segment segment = renderWorld.WallSegment(wallIndex);
+
+                HitInfo wallHitInfo;
+                if(!RayToSegmentCollision(ray, segment, wallHitInfo)) continue;
+
+                if(renderWorld.wallToSector[wallIndex] != NULL_SECTOR_INDEX 
+                    && PointSegmentSide(ray.position, segment.a, segment.b) <= 0)
+                {
+                    continue;
+                }
+
+                // Same rejection as the culled walls of the other modes
+                if(renderWorld.wallToSector[wallIndex] != NULL_SECTOR_INDEX
+                    && !renderWorld.IsSectorPotentiallyVisible(viewSectorIndex, renderWorld.wallToSector[wallIndex]))
+                {
+                    continue;
+                }
+
+                if(wallHitInfo.distance < bestDistance || (wallHitInfo.distance == bestDistance && wallIndex < bestWallIndex))
+                {
+                    bestDistance = wallHitInfo.distance;
+                    bestWallIndex = wallIndex;
+                    hitInfo = wallHitInfo;
+                }
+            }
+
+            continue;
+        }
+
+        // Nearest child is pushed last so it is visited first
+        PendingNode children[2];
+        uint32_t childrenCount = 0;
+
+        for(uint32_t child = node.first; child < node.first + 2; ++child)
+        {
+            float entry;
+            if(RayToBoxEntry(boxRay, renderWorld.wallBvhNodes[child], entry))
+            {
+                children[childrenCount++] = { child, entry * directionLength };
+            }
+        }
+
+        if(childrenCount == 2 && children[0].entryDistance < children[1].entryDistance)
+        {
+            std::swap(children[0], children[1]);
+        }
+
+        // "Wall BVH deeper than WallBvhMaxDepth"
+        assert(pendingNodesCount + childrenCount <= WallBvhMaxDepth + 1);
+
+        for(uint32_t i = 0; i < childrenCount; ++i)
+        {
+            pendingNodes[pendingNodesCount++] = children[i];
+        }
+    }
+
+    return bestWallIndex;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "Renderer/RaycastingMath.hpp"
+#include "Renderer/RaycastingMathSimd.hpp"
+#include "Renderer/WallTexture.hpp"
+
+struct World;
+
+// Dense index of a sector in a RenderWorld, portals are resolved to these
+using SectorIndex = uint32_t;
+constexpr SectorIndex NULL_SECTOR_INDEX { static_cast<SectorIndex>(-1) };
+
+// Index of a wall in the RenderWorld flat wall arrays
+using WallIndex = uint32_t;
+constexpr WallIndex NULL_WALL_INDEX { static_cast<WallIndex>(-1) };
+
+// Sectors with at least that many walls get a wall BVH
+constexpr uint32_t WallBvhMinWallsCount = 32;
+constexpr uint32_t NULL_WALL_BVH_NODE { static_cast<uint32_t>(-1) };
+
+// Bounding box tree node over the walls of one sector.
+// Leaves hold wallsCount walls from RenderWorld::wallBvhWalls[first], inner nodes have wallsCount == 0
+// and their two children at nodes first and first + 1.
+struct WallBvhNode
+{
+    Vector2 min { 0 };
+    Vector2 max { 0 };
+    uint32_t first      { 0 };
+    uint32_t wallsCount { 0 };
+};
+
+// Data read for every sector visit
+struct RenderSector
+{
+    WallIndex wallsBegin { 0 };
+    uint32_t wallsCount  { 0 };
+    float zCeiling       { 1 };
+    float zFloor         { 1 };
+    // Root of the sector wall BVH, NULL_WALL_BVH_NODE below WallBvhMinWallsCount walls
+    uint32_t wallBvhRoot { NULL_WALL_BVH_NODE };
+};
+
+// Only read when something is drawn
+struct RenderSectorColors
+{
+    Color floor;
+    Color ceiling;
+    Color topBorder;
+    Color bottomBorder;
+};
+
+/// Flat, index addressed snapshot of a World built for the rasterizer.
+/// Sectors are stored in a dense array ordered by SectorID, all the walls live in one set of arrays
+/// where each sector owns a contiguous range starting on a WallsBatchSize boundary (padded with
+/// degenerate walls) so the SIMD kernels can read a sector walls directly.
+struct RenderWorld
+{
+    std::vector<RenderSector> sectors;
+    std::vector<RenderSectorColors> sectorColors;
+    std::vector<SectorID> sectorIds;
+
+    // Hot wall geometry
+    std::vector<float> wallAx;
+    std::vector<float> wallAy;
+    std::vector<float> wallBx;
+    std::vector<float> wallBy;
+    std::vector<SectorIndex> wallToSector;
+
+    // Cold wall data
+    std::vector<Color> wallColors;
+    std::vector<WallTextureID> wallTextures;
+
+    // Textures used by the walls of each sector, once each, they are the ones a sector visit requests.
+    // Sector s owns sectorTextures[sectorTexturesBegin[s], sectorTexturesBegin[s + 1][.
+    std::vector<uint32_t> sectorTexturesBegin;
+    std::vector<WallTextureID> sectorTextures;
+    // Size of World::wallTextures, walls referencing an id past it are drawn flat
+    uint32_t texturesCount { 0 };
+
+    // Wall BVHs of the big sectors, every sector tree is stored contiguously
+    std::vector<WallBvhNode> wallBvhNodes;
+    std::vector<WallIndex> wallBvhWalls;
+
+    // Potentially visible sets, bit "to" of the pvsWordsPerSector words of sector "from" is set when some
+    // point of "from" may see "to" through its portals, see BuildSectorsPvs. Empty when not built.
+    std::vector<uint64_t> sectorsPvs;
+    uint32_t pvsWordsPerSector { 0 };
+    // Incremented by CompileRenderWorld when a sector, wall segment or portal changes, the sets are built for one layout
+    uint64_t layoutRevision { 0 };
+
+    // Only used to translate SectorIDs coming from outside (camera, editor), never in the rasterization loops
+    std::unordered_map<SectorID, SectorIndex> sectorIndices;
+
+    SectorIndex FindSectorIndex(SectorID sectorId) const
+    {
+        auto it = sectorIndices.find(sectorId);
+        return (it != sectorIndices.end()) ? it->second : NULL_SECTOR_INDEX;
+    }
+
+    // Every sector counts as visible when the sets are not built
+    bool IsSectorPotentiallyVisible(SectorIndex from, SectorIndex to) const
+    {
+        if(sectorsPvs.empty()) return true;
+
+        return (sectorsPvs[from * pvsWordsPerSector + (to >> 6)] >> (to & 63)) & 1;
+    }
+
+    std::span<const WallTextureID> SectorTextures(SectorIndex sectorIndex) const
+    {
+        return std::span<const WallTextureID>(sectorTextures).subspan(
+            sectorTexturesBegin[sectorIndex], sectorTexturesBegin[sectorIndex + 1] - sectorTexturesBegin[sectorIndex]);
+    }
+
+    Segment WallSegment(WallIndex wallIndex) const
+    {
+        return {
+            { wallAx[wallIndex], wallAy[wallIndex] },
+            { wallBx[wallIndex], wallBy[wallIndex] },
+        };
+    }
+
+    WallsSoAView SectorWalls(SectorIndex sectorIndex) const
+    {
+        const RenderSector& sector = sectors[sectorIndex];
+
+        return {
+            .ax = wallAx.data() + sector.wallsBegin,
+            .ay = wallAy.data() + sector.wallsBegin,
+            .bx = wallBx.data() + sector.wallsBegin,
+            .by = wallBy.data() + sector.wallsBegin,
+            .toSector = wallToSector.data() + sector.wallsBegin,
+            .count = sector.wallsCount,
+            .paddedCount = PaddedWallsCount(sector.wallsCount),
+        };
+    }
+};
+
+/// @brief Rebuilds renderWorld from world, the renderWorld storage is reused
+/// The potentially visible sets are kept until a wall segment or a portal changes, they are then dropped
+/// and layoutRevision moves on. Building them is left to BuildSectorsPvs or a SectorPvsBuilder.
+void CompileRenderWorld(const World& world, RenderWorld& renderWorld);
+
+/// @brief Nearest wall hit of a ray in a sector that has a wall BVH, in O(log walls) for rays that hit a near wall
+/// Portals seen from behind the ray position are skipped, so are portals to sectors viewSectorIndex can't see.
+/// @return hit wall index, NULL_WALL_INDEX when nothing is hit
+/// Gives the same wall as testing every other wall of the sector with RayToSegmentCollision and keeping the first nearest.
+WallIndex RayToSectorWallBvhNearestHit(const RenderWorld& renderWorld, SectorIndex sectorIndex, SectorIndex viewSectorIndex, const RasterRay& ray, HitInfo& hitInfo);
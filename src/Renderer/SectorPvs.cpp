@@ -0,0 +1,507 @@
+#include "SectorPvs.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <span>
+#include <vector>
+
+#include "Utils/JobSystem.hpp"
+
+namespace
+{
+    // Clip tolerance relative to the world size. Rasterizer rays drift off their exact line by a few
+    // float ulps of the coordinates per unit of distance, the tolerance has to cover that.
+    constexpr float PvsClipRelativeMargin = 1e-4f;
+
+    constexpr uint32_t NULL_PVS_PORTAL = static_cast<uint32_t>(-1);
+
+    // Portal walls of every sector, the flow never looks at solid walls
+    struct PvsPortals
+    {
+        // Portals of sector s are [sectorPortalsBegin[s], sectorPortalsBegin[s + 1][
+        std::vector<uint32_t> sectorPortalsBegin;
+        std::vector<Segment> segments;
+        std::vector<SectorIndex> toSectors;
+        // Portal of the sector on the other side with the same segment, NULL_PVS_PORTAL when there is none
+        std::vector<uint32_t> twins;
+        // Per portal, wordsCount words of the sectors reachable through portals lying past it ("might see"
+        // of Quake vis). Loose, but it lets the flow stop following chains that can't reveal a new sector.
+        std::vector<uint64_t> mightSee;
+    };
+
+    // A sector of the portal chain being followed, the portal flow clips every next portal to the
+    // lines going through source (the first portal, seen from the source sector) and pass (the last one)
+    struct PvsChainStep
+    {
+        SectorIndex sectorIndex;
+        Segment source;
+        Segment pass;
+        uint32_t passPortal;
+        uint32_t nextPortal;
+    };
+
+    // Scratch memory of one worker
+    struct PvsBuildScratch
+    {
+        std::vector<PvsChainStep> chain;
+        // wordsCount words per chain step, the might see sets of its portals intersected
+        std::vector<uint64_t> chainMightSee;
+        // One flag per portal, a line never crosses the same portal twice
+        std::vector<uint8_t> inChainPortals;
+        std::vector<SectorIndex> floodQueue;
+    };
+
+    struct PvsBuildContext
+    {
+        RenderWorld* renderWorld;
+        uint32_t wordsCount;
+        float clipMargin;
+        PvsPortals portals;
+        std::vector<PvsBuildScratch> workersScratch;
+        const std::atomic<bool>* cancelRequested;
+    };
+
+    bool IsCancelRequested(const PvsBuildContext& ctx)
+    {
+        return ctx.cancelRequested != nullptr && ctx.cancelRequested->load(std::memory_order_relaxed);
+    }
+
+    void MarkVisible(std::span<uint64_t> pvs, SectorIndex sectorIndex)
+    {
+        pvs[sectorIndex >> 6] |= uint64_t(1) << (sectorIndex & 63);
+    }
+
+    bool IsMarkedVisible(std::span<const uint64_t> pvs, SectorIndex sectorIndex)
+    {
+        return (pvs[sectorIndex >> 6] >> (sectorIndex & 63)) & 1;
+    }
+
+    // Keeps the part of segment where side * (signed distance to the line a b) >= -margin,
+    // false when nothing is left. Positive distances are on the front of a wall, see PointSegmentSide.
+    bool ClipSegmentToSide(Segment& segment, Vector2 a, Vector2 b, float side, float margin)
+    {
+        const float lineLength = Vector2Distance(a, b);
+        if(lineLength == 0) return true;
+
+        const float distanceA = side * PointSegmentSide(segment.a, a, b) / lineLength + margin;
+        const float distanceB = side * PointSegmentSide(segment.b, a, b) / lineLength + margin;
+
+        if(distanceA >= 0 && distanceB >= 0) return true;
+        if(distanceA < 0 && distanceB < 0) return false;
+
+        const float t = distanceA / (distanceA - distanceB);
+        const Vector2 cut = {
+            segment.a.x + t * (segment.b.x - segment.a.x),
+            segment.a.y + t * (segment.b.y - segment.a.y),
+        };
+
+        if(distanceA < 0) segment.a = cut;
+        else segment.b = cut;
+
+        return true;
+    }
+
+    // Part of target a line going through source then pass can reach, false when there is none
+    bool ClipToPortalFlow(const Segment& source, const Segment& pass, Segment& target, float margin)
+    {
+        // Lines past a portal stay behind it
+        if(!ClipSegmentToSide(target, source.a, source.b, -1, margin)) return false;
+        if(!ClipSegmentToSide(target, pass.a, pass.b, -1, margin)) return false;
+
+        const Vector2 sourcePoints[2] = { source.a, source.b };
+        const Vector2 passPoints[2] = { pass.a, pass.b };
+
+        // Separating lines join a source end to a pass end and leave the other two ends on opposite sides,
+        // past the pass portal every line through both portals is on the side of the other pass end
+        for(int i = 0; i < 2; ++i)
+        {
+            for(int j = 0; j < 2; ++j)
+            {
+                const Vector2 a = sourcePoints[i];
+                const Vector2 b = passPoints[j];
+
+                const float lineLength = Vector2Distance(a, b);
+                if(lineLength <= margin) continue;
+
+                const float sourceSide = PointSegmentSide(sourcePoints[1 - i], a, b) / lineLength;
+                const float passSide = PointSegmentSide(passPoints[1 - j], a, b) / lineLength;
+
+                // Nearly aligned ends give no reliable separator, skipping one only keeps more
+                if(fabsf(sourceSide) <= margin || fabsf(passSide) <= margin) continue;
+                if((sourceSide > 0) == (passSide > 0)) continue;
+
+                if(!ClipSegmentToSide(target, a, b, passSide > 0 ? 1.f : -1.f, margin)) return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool IsSameSegment(const Segment& a, const Segment& b)
+    {
+        const auto samePoint = [](Vector2 p, Vector2 q) { return p.x == q.x && p.y == q.y; };
+
+        return (samePoint(a.a, b.a) && samePoint(a.b, b.b)) || (samePoint(a.a, b.b) && samePoint(a.b, b.a));
+    }
+
+    bool CanRevealMore(std::span<const uint64_t> mightSee, std::span<const uint64_t> pvs)
+    {
+        for(size_t i = 0; i < pvs.size(); ++i)
+        {
+            if(mightSee[i] & ~pvs[i]) return true;
+        }
+
+        return false;
+    }
+
+    // Every sector reached through portals, the fallback of the sources whose portal flow is too long.
+    // pvs may hold a partial flow, it is cleared first.
+    void FloodSectorPvs(const PvsPortals& portals, SectorIndex sourceSector, std::span<uint64_t> pvs, std::vector<SectorIndex>& floodQueue)
+    {
+        std::fill(pvs.begin(), pvs.end(), 0);
+
+        floodQueue.clear();
+        floodQueue.push_back(sourceSector);
+        MarkVisible(pvs, sourceSector);
+
+        for(size_t i = 0; i < floodQueue.size(); ++i)
+        {
+            for(uint32_t portal = portals.sectorPortalsBegin[floodQueue[i]]; portal < portals.sectorPortalsBegin[floodQueue[i] + 1]; ++portal)
+            {
+                const SectorIndex toSector = portals.toSectors[portal];
+                if(IsMarkedVisible(pvs, toSector)) continue;
+
+                MarkVisible(pvs, toSector);
+                floodQueue.push_back(toSector);
+            }
+        }
+    }
+
+    // Sectors reached from the portal through the portals partly past its line and partly facing it
+    void BuildPortalMightSee(PvsBuildContext& ctx, uint32_t portal, PvsBuildScratch& scratch)
+    {
+        PvsPortals& portals = ctx.portals;
+        const std::span<uint64_t> mightSee(portals.mightSee.data() + static_cast<size_t>(portal) * ctx.wordsCount, ctx.wordsCount);
+        const Segment& portalSegment = portals.segments[portal];
+
+        scratch.floodQueue.clear();
+        scratch.floodQueue.push_back(portals.toSectors[portal]);
+        MarkVisible(mightSee, portals.toSectors[portal]);
+
+        for(size_t i = 0; i < scratch.floodQueue.size(); ++i)
+        {
+            const SectorIndex sectorIndex = scratch.floodQueue[i];
+
+            for(uint32_t next = portals.sectorPortalsBegin[sectorIndex]; next < portals.sectorPortalsBegin[sectorIndex + 1]; ++next)
+            {
+                const SectorIndex toSector = portals.toSectors[next];
+                if(IsMarkedVisible(mightSee, toSector)) continue;
+
+                Segment target = portals.segments[next];
+                if(!ClipSegmentToSide(target, portalSegment.a, portalSegment.b, -1, ctx.clipMargin)) continue;
+
+                Segment source = portalSegment;
+                if(!ClipSegmentToSide(source, portals.segments[next].a, portals.segments[next].b, 1, ctx.clipMargin)) continue;
+
+                MarkVisible(mightSee, toSector);
+                scratch.floodQueue.push_back(toSector);
+            }
+        }
+    }
+
+    // False when the portal visits budget ran out, pvs is then partial
+    bool FlowSectorPvs(PvsBuildContext& ctx, SectorIndex sourceSector, std::span<uint64_t> pvs, PvsBuildScratch& scratch)
+    {
+        const PvsPortals& portals = ctx.portals;
+        const uint32_t wordsCount = ctx.wordsCount;
+
+        MarkVisible(pvs, sourceSector);
+
+        uint32_t portalVisitsCount = 0;
+
+        for(uint32_t firstPortal = portals.sectorPortalsBegin[sourceSector]; firstPortal < portals.sectorPortalsBegin[sourceSector + 1]; ++firstPortal)
+        {
+            const SectorIndex nextSector = portals.toSectors[firstPortal];
+
+            // Anywhere in the source sector is in front of its own portals
+            MarkVisible(pvs, nextSector);
+
+            scratch.chain.push_back({
+                .sectorIndex = nextSector,
+                .source = portals.segments[firstPortal],
+                .pass = portals.segments[firstPortal],
+                .passPortal = firstPortal,
+                .nextPortal = portals.sectorPortalsBegin[nextSector],
+            });
+            scratch.inChainPortals[firstPortal] = 1;
+
+            scratch.chainMightSee.resize(wordsCount);
+            std::copy_n(portals.mightSee.begin() + static_cast<size_t>(firstPortal) * wordsCount, wordsCount, scratch.chainMightSee.begin());
+
+            while(!scratch.chain.empty())
+            {
+                const size_t stepLevel = scratch.chain.size() - 1;
+                PvsChainStep& step = scratch.chain.back();
+                const std::span<const uint64_t> stepMightSee(scratch.chainMightSee.data() + stepLevel * wordsCount, wordsCount);
+
+                if(step.nextPortal == portals.sectorPortalsBegin[step.sectorIndex + 1] || !CanRevealMore(stepMightSee, pvs))
+                {
+                    scratch.inChainPortals[step.passPortal] = 0;
+                    scratch.chain.pop_back();
+                    continue;
+                }
+
+                const uint32_t portal = step.nextPortal++;
+                const SectorIndex toSector = portals.toSectors[portal];
+
+                // The other side of the portal the chain just went through is never crossed
+                if(scratch.inChainPortals[portal] || portal == portals.twins[step.passPortal]) continue;
+                if(!IsMarkedVisible(stepMightSee, toSector)) continue;
+
+                if(++portalVisitsCount > PvsMaxPortalVisitsPerSector)
+                {
+                    for(const PvsChainStep& chainStep : scratch.chain)
+                    {
+                        scratch.inChainPortals[chainStep.passPortal] = 0;
+                    }
+                    scratch.chain.clear();
+
+                    return false;
+                }
+
+                Segment target = portals.segments[portal];
+                if(!ClipToPortalFlow(step.source, step.pass, target, ctx.clipMargin)) continue;
+
+                // The rasterizer only looks through portals from their front
+                Segment source = step.source;
+                if(!ClipSegmentToSide(source, portals.segments[portal].a, portals.segments[portal].b, 1, ctx.clipMargin)) continue;
+
+                MarkVisible(pvs, toSector);
+
+                const PvsChainStep nextStep = {
+                    .sectorIndex = toSector,
+                    .source = source,
+                    .pass = target,
+                    .passPortal = portal,
+                    .nextPortal = portals.sectorPortalsBegin[toSector],
+                };
+
+                scratch.inChainPortals[portal] = 1;
+                scratch.chain.push_back(nextStep);
+
+                scratch.chainMightSee.resize((stepLevel + 2) * wordsCount);
+                for(uint32_t i = 0; i < wordsCount; ++i)
+                {
+                    scratch.chainMightSee[(stepLevel + 1) * wordsCount + i] = scratch.chainMightSee[stepLevel * wordsCount + i] 
+                        & portals.mightSee[static_cast<size_t>(portal) * wordsCount + i];
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void GatherPvsPortals(const RenderWorld& renderWorld, PvsPortals& portals)
+    {
+        const uint32_t sectorsCount = static_cast<uint32_t>(renderWorld.sectors.size());
+
+        portals.sectorPortalsBegin.assign(1, 0);
+
+        for(SectorIndex sectorIndex = 0; sectorIndex < sectorsCount; ++sectorIndex)
+        {
+            const RenderSector& sector = renderWorld.sectors[sectorIndex];
+
+            for(WallIndex wallIndex = sector.wallsBegin; wallIndex < sector.wallsBegin + sector.wallsCount; ++wallIndex)
+            {
+                if(renderWorld.wallToSector[wallIndex] == NULL_SECTOR_INDEX) continue;
+
+                portals.segments.push_back(renderWorld.WallSegment(wallIndex));
+                portals.toSectors.push_back(renderWorld.wallToSector[wallIndex]);
+            }
+
+            portals.sectorPortalsBegin.push_back(static_cast<uint32_t>(portals.segments.size()));
+        }
+
+        portals.twins.assign(portals.segments.size(), NULL_PVS_PORTAL);
+
+        for(uint32_t portal = 0; portal < portals.segments.size(); ++portal)
+        {
+            const SectorIndex toSector = portals.toSectors[portal];
+
+            for(uint32_t other = portals.sectorPortalsBegin[toSector]; other < portals.sectorPortalsBegin[toSector + 1]; ++other)
+            {
+                if(IsSameSegment(portals.segments[portal], portals.segments[other]))
+                {
+                    portals.twins[portal] = other;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool BuildSectorsPvs(RenderWorld& renderWorld, JobSystem& jobSystem, const std::atomic<bool>* cancelRequested)
+{
+    const uint32_t sectorsCount = static_cast<uint32_t>(renderWorld.sectors.size());
+
+    renderWorld.pvsWordsPerSector = (sectorsCount + 63) / 64;
+    renderWorld.sectorsPvs.assign(static_cast<size_t>(sectorsCount) * renderWorld.pvsWordsPerSector, 0);
+
+    if(sectorsCount == 0) return true;
+
+    Vector2 min = { INFINITY, INFINITY };
+    Vector2 max = { -INFINITY, -INFINITY };
+
+    for(const RenderSector& sector : renderWorld.sectors)
+    {
+        for(WallIndex wallIndex = sector.wallsBegin; wallIndex < sector.wallsBegin + sector.wallsCount; ++wallIndex)
+        {
+            const Segment segment = renderWorld.WallSegment(wallIndex);
+            min = Vector2Min(min, Vector2Min(segment.a, segment.b));
+            max = Vector2Max(max, Vector2Max(segment.a, segment.b));
+        }
+    }
+
+    const float worldExtent = std::max({ max.x - min.x, max.y - min.y, fabsf(min.x), fabsf(min.y), fabsf(max.x), fabsf(max.y) });
+
+    PvsBuildContext ctx {
+        .renderWorld = &renderWorld,
+        .wordsCount = renderWorld.pvsWordsPerSector,
+        .clipMargin = PvsClipRelativeMargin * worldExtent + 1e-3f,
+        .portals = {},
+        .workersScratch = {},
+        .cancelRequested = cancelRequested,
+    };
+
+    GatherPvsPortals(renderWorld, ctx.portals);
+
+    const uint32_t portalsCount = static_cast<uint32_t>(ctx.portals.segments.size());
+    ctx.portals.mightSee.assign(static_cast<size_t>(portalsCount) * ctx.wordsCount, 0);
+
+    ctx.workersScratch.resize(jobSystem.GetWorkersCount());
+    for(PvsBuildScratch& scratch : ctx.workersScratch)
+    {
+        scratch.inChainPortals.assign(portalsCount, 0);
+    }
+
+    // Each job only writes the words of its own portal, then of its own source sector
+    jobSystem.ParallelFor(portalsCount, [](void* data, uint32_t portal, uint32_t workerIndex)
+    {
+        PvsBuildContext& ctx = *static_cast<PvsBuildContext*>(data);
+        if(IsCancelRequested(ctx)) return;
+
+        BuildPortalMightSee(ctx, portal, ctx.workersScratch[workerIndex]);
+    }, &ctx);
+
+    jobSystem.ParallelFor(sectorsCount, [](void* data, uint32_t sectorIndex, uint32_t workerIndex)
+    {
+        PvsBuildContext& ctx = *static_cast<PvsBuildContext*>(data);
+        if(IsCancelRequested(ctx)) return;
+
+        PvsBuildScratch& scratch = ctx.workersScratch[workerIndex];
+
+        const std::span<uint64_t> pvs(ctx.renderWorld->sectorsPvs.data() + static_cast<size_t>(sectorIndex) * ctx.wordsCount, ctx.wordsCount);
+
+        if(!FlowSectorPvs(ctx, sectorIndex, pvs, scratch))
+        {
+            FloodSectorPvs(ctx.portals, sectorIndex, pvs, scratch.floodQueue);
+        }
+    }, &ctx);
+
+    // Sectors skipped by the cancellation would see nothing, partial sets are not conservative
+    if(IsCancelRequested(ctx))
+    {
+        renderWorld.sectorsPvs.clear();
+        return false;
+    }
+
+    return true;
+}
+
+uint32_t CountPotentiallyVisibleSectors(const RenderWorld& renderWorld, SectorIndex sectorIndex)
+{
+    if(renderWorld.sectorsPvs.empty()) return static_cast<uint32_t>(renderWorld.sectors.size());
+
+    uint32_t count = 0;
+    for(uint32_t i = 0; i < renderWorld.pvsWordsPerSector; ++i)
+    {
+        count += static_cast<uint32_t>(std::popcount(renderWorld.sectorsPvs[sectorIndex * renderWorld.pvsWordsPerSector + i]));
+    }
+
+    return count;
+}
+
+SectorPvsBuilder::~SectorPvsBuilder()
+{
+    Cancel();
+}
+
+void SectorPvsBuilder::Update(RenderWorld& renderWorld)
+{
+    if(!renderWorld.sectorsPvs.empty()) return;
+
+    if(!hasLayout || layoutRevision != renderWorld.layoutRevision)
+    {
+        Start(renderWorld);
+        return;
+    }
+
+    if(thread.joinable())
+    {
+        if(!isDone.load(std::memory_order_acquire)) return;
+
+        thread.join();
+    }
+
+    // Empty once handed over, or when the layout has no sector
+    renderWorld.sectorsPvs.swap(layout.sectorsPvs);
+    renderWorld.pvsWordsPerSector = layout.pvsWordsPerSector;
+}
+
+void SectorPvsBuilder::Wait()
+{
+    if(thread.joinable())
+    {
+        thread.join();
+    }
+}
+
+void SectorPvsBuilder::Cancel()
+{
+    if(thread.joinable())
+    {
+        cancelRequested.store(true, std::memory_order_relaxed);
+        thread.join();
+        cancelRequested.store(false, std::memory_order_relaxed);
+    }
+
+    layout.sectorsPvs.clear();
+    hasLayout = false;
+}
+
+void SectorPvsBuilder::Start(const RenderWorld& renderWorld)
+{
+    Cancel();
+
+    // The flow only reads the sectors and the wall geometry
+    layout.sectors = renderWorld.sectors;
+    layout.wallAx = renderWorld.wallAx;
+    layout.wallAy = renderWorld.wallAy;
+    layout.wallBx = renderWorld.wallBx;
+    layout.wallBy = renderWorld.wallBy;
+    layout.wallToSector = renderWorld.wallToSector;
+
+    layoutRevision = renderWorld.layoutRevision;
+    hasLayout = true;
+    isDone.store(false, std::memory_order_relaxed);
+
+    thread = std::thread([this]()
+    {
+        // Serial, the process job system belongs to the frames
+        JobSystem jobSystem(1);
+        BuildSectorsPvs(layout, jobSystem, &cancelRequested);
+
+        isDone.store(true, std::memory_order_release);
+    });
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "Renderer/RenderWorld.hpp"
+#include "Utils/JobSystem.hpp"
+
+// Portal visits allowed per source sector, past that the sector falls back to every sector its portals lead to
+constexpr uint32_t PvsMaxPortalVisitsPerSector = 1U << 16;
+
+/// @brief Fills renderWorld.sectorsPvs, the sectors that may be seen from anywhere inside each sector.
+/// Portal chains are followed from every portal of the source sector, each portal being clipped to the
+/// lines that can pass through the source portal and the previous one (2D portal flow, like Quake vis).
+/// Sets are conservative: a sector left out can't be hit by any ray cast from inside the source sector,
+/// using the same portal facing rule as the rasterizer. Source sectors are processed in parallel on jobSystem.
+/// @param cancelRequested checked between portals and between sectors, may be null
+/// @return false when the build was cancelled, the sets are then left empty
+bool BuildSectorsPvs(RenderWorld& renderWorld, JobSystem& jobSystem = GetJobSystem(), const std::atomic<bool>* cancelRequested = nullptr);
+
+/// @brief Number of sectors in the potentially visible set of sectorIndex
+uint32_t CountPotentiallyVisibleSectors(const RenderWorld& renderWorld, SectorIndex sectorIndex);
+
+/// Builds the potentially visible sets of a RenderWorld on a thread of its own, off the frame path.
+/// The sectors and walls are copied when a build starts, the sets are only handed to a RenderWorld
+/// with the same layoutRevision. Until then its sets stay empty and every sector counts as visible.
+class SectorPvsBuilder
+{
+public:
+    SectorPvsBuilder() = default;
+    ~SectorPvsBuilder();
+
+    SectorPvsBuilder(const SectorPvsBuilder&) = delete;
+    SectorPvsBuilder& operator=(const SectorPvsBuilder&) = delete;
+
+    // To be called once renderWorld is compiled, starts a build when its layout has none (cancelling
+    // the previous one) and gives it the sets once they are done. Never waits for the build thread.
+    void Update(RenderWorld& renderWorld);
+    // Blocks until the running build is done, the next Update hands its sets over
+    void Wait();
+    void Cancel();
+
+    bool IsBuilding() const { return thread.joinable() && !isDone.load(std::memory_order_acquire); }
+
+private:
+    void Start(const RenderWorld& renderWorld);
+
+    std::thread thread;
+    std::atomic<bool> cancelRequested { false };
+    std::atomic<bool> isDone { false };
+
+    // Sectors and walls of the build, its sets once it is done, only the build thread touches it while it runs
+    RenderWorld layout;
+    uint64_t layoutRevision { 0 };
+    bool hasLayout { false };
+};
@@ -0,0 +1,207 @@
+#include "SectorSpatialIndex.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "Renderer/World.hpp"
+
+namespace
+{
+    // Grid cells per sector, more cells shorten the candidate lists but big sectors then span more cells
+    constexpr float CellsPerSector = 1.f;
+    constexpr uint32_t MaxCellsCount = 1U << 22;
+
+    bool IsPointInIndexedSector(Vector2 point, const SectorSpatialIndex& index, uint32_t sector)
+    {
+        const Rectangle& bounds = index.sectorBounds[sector];
+
+        if(point.x < bounds.x || point.x > bounds.x + bounds.width 
+            || point.y < bounds.y || point.y > bounds.y + bounds.height)
+        {
+            return false;
+        }
+
+        bool inside = false;
+        for(uint32_t i = index.sectorWallsBegins[sector]; i < index.sectorWallsBegins[sector + 1]; ++i)
+        {
+            if(IsSegmentCrossedByPointRay(point, index.walls[i].a, index.walls[i].b))
+            {
+                inside = !inside;
+            }
+        }
+
+        return inside;
+    }
+
+    void CellRange(const SectorSpatialIndex& index, float min, float max, float origin, uint32_t cellsCount, uint32_t& outBegin, uint32_t& outEnd)
+    {
+        const float cellBegin = floorf((min - origin) * index.inverseCellSize);
+        const float cellEnd = floorf((max - origin) * index.inverseCellSize);
+
+        outBegin = static_cast<uint32_t>(std::clamp(cellBegin, 0.f, static_cast<float>(cellsCount - 1)));
+        outEnd = static_cast<uint32_t>(std::clamp(cellEnd, 0.f, static_cast<float>(cellsCount - 1)));
+    }
+}
+
+bool SectorSpatialIndex::IsUpToDate(const World& world) const
+{
+    return built && revision == world.revision;
+}
+
+void BuildSectorSpatialIndex(const World& world, SectorSpatialIndex& index)
+{
+    index.revision = world.revision;
+    index.built = true;
+
+    index.sectorIds.clear();
+    index.sectorBounds.clear();
+    index.sectorWallsBegins.clear();
+    index.walls.clear();
+    index.cellBegins.clear();
+    index.cellSectors.clear();
+
+    for(const auto& [ sectorId, sector ] : world.Sectors)
+    {
+        index.sectorIds.push_back(sectorId);
+    }
+
+    std::sort(index.sectorIds.begin(), index.sectorIds.end());
+
+    Vector2 worldMin = { INFINITY, INFINITY };
+    Vector2 worldMax = { -INFINITY, -INFINITY };
+
+    for(SectorID sectorId : index.sectorIds)
+    {
+        const Sector& sector = world.Sectors.at(sectorId);
+
+        Vector2 sectorMin = { INFINITY, INFINITY };
+        Vector2 sectorMax = { -INFINITY, -INFINITY };
+
+        index.sectorWallsBegins.push_back(static_cast<uint32_t>(index.walls.size()));
+
+        for(const Wall& wall : sector.walls)
+        {
+            index.walls.push_back(wall.segment);
+
+            sectorMin = Vector2Min(sectorMin, Vector2Min(wall.segment.a, wall.segment.b));
+            sectorMax = Vector2Max(sectorMax, Vector2Max(wall.segment.a, wall.segment.b));
+        }
+
+        if(sector.walls.empty())
+        {
+            sectorMin = sectorMax = { 0 };
+        }
+
+        index.sectorBounds.push_back({ sectorMin.x, sectorMin.y, sectorMax.x - sectorMin.x, sectorMax.y - sectorMin.y });
+
+        worldMin = Vector2Min(worldMin, sectorMin);
+        worldMax = Vector2Max(worldMax, sectorMax);
+    }
+
+    index.sectorWallsBegins.push_back(static_cast<uint32_t>(index.walls.size()));
+
+    const size_t sectorsCount = index.sectorIds.size();
+
+    if(sectorsCount == 0)
+    {
+        index.origin = { 0 };
+        index.inverseCellSize = 0;
+        index.columns = index.rows = 1;
+        index.cellBegins.assign(2, 0);
+        return;
+    }
+
+    // Square cells, about CellsPerSector of them per sector over the world bounds
+    const Vector2 worldSize = Vector2Subtract(worldMax, worldMin);
+    const float worldArea = std::max(worldSize.x, 1.f) * std::max(worldSize.y, 1.f);
+    const float cellsCountTarget = std::min(static_cast<float>(sectorsCount) * CellsPerSector, static_cast<float>(MaxCellsCount));
+    const float cellSize = std::max(sqrtf(worldArea / cellsCountTarget), 1e-3f);
+
+    index.origin = worldMin;
+    index.inverseCellSize = 1.f / cellSize;
+    index.columns = std::clamp(static_cast<uint32_t>(ceilf(worldSize.x / cellSize)), 1U, MaxCellsCount);
+    index.rows = std::clamp(static_cast<uint32_t>(ceilf(worldSize.y / cellSize)), 1U, MaxCellsCount / index.columns);
+
+    // Two passes, count then fill, so the cells end up in one flat array
+    index.cellBegins.assign(static_cast<size_t>(index.columns) * index.rows + 1, 0);
+
+    const auto forEachSectorCell = [&index](uint32_t sector, auto&& function)
+    {
+        const Rectangle& bounds = index.sectorBounds[sector];
+
+        uint32_t xBegin, xEnd, yBegin, yEnd;
+        CellRange(index, bounds.x, bounds.x + bounds.width, index.origin.x, index.columns, xBegin, xEnd);
+        CellRange(index, bounds.y, bounds.y + bounds.height, index.origin.y, index.rows, yBegin, yEnd);
+
+        for(uint32_t y = yBegin; y <= yEnd; ++y)
+        {
+            for(uint32_t x = xBegin; x <= xEnd; ++x)
+            {
+                function(static_cast<size_t>(y) * index.columns + x);
+            }
+        }
+    };
+
+    for(uint32_t sector = 0; sector < sectorsCount; ++sector)
+    {
+        forEachSectorCell(sector, [&index](size_t cell) { ++index.cellBegins[cell + 1]; });
+    }
+
+    for(size_t cell = 1; cell < index.cellBegins.size(); ++cell)
+    {
+        index.cellBegins[cell] += index.cellBegins[cell - 1];
+    }
+
+    index.cellSectors.resize(index.cellBegins.back());
+
+    // Sectors are visited by increasing SectorID, so every cell list comes out sorted
+    std::vector<uint32_t> cellFill(index.cellBegins.begin(), index.cellBegins.end() - 1);
+
+    for(uint32_t sector = 0; sector < sectorsCount; ++sector)
+    {
+        forEachSectorCell(sector, [&index, &cellFill, sector](size_t cell) { index.cellSectors[cellFill[cell]++] = sector; });
+    }
+}
+
+SectorID FindSectorOfPoint(Vector2 point, const SectorSpatialIndex& index)
+{
+    // "FindSectorOfPoint called on an index that was never built"
+    assert(index.built);
+
+    const float cellX = floorf((point.x - index.origin.x) * index.inverseCellSize);
+    const float cellY = floorf((point.y - index.origin.y) * index.inverseCellSize);
+
+    // Outside the grid means outside every sector box, points exactly on the max border land one cell past
+    // the grid and are clamped back, NaN coordinates fail these tests as well
+    if(!(cellX >= 0 && cellX <= index.columns && cellY >= 0 && cellY <= index.rows))
+    {
+        return NULL_SECTOR;
+    }
+
+    const size_t cell = static_cast<size_t>(std::min(cellY, static_cast<float>(index.rows - 1))) * index.columns
+        + static_cast<size_t>(std::min(cellX, static_cast<float>(index.columns - 1)));
+
+    for(uint32_t i = index.cellBegins[cell]; i < index.cellBegins[cell + 1]; ++i)
+    {
+        const uint32_t sector = index.cellSectors[i];
+
+        if(IsPointInIndexedSector(point, index, sector))
+        {
+            return index.sectorIds[sector];
+        }
+    }
+
+    return NULL_SECTOR;
+}
+
+void FindSectorsOfPoints(std::span<const Vector2> points, const SectorSpatialIndex& index, std::span<SectorID> outSectorIds)
+{
+    // "outSectorIds must hold one entry per point"
+    assert(points.size() == outSectorIds.size());
+
+    for(size_t i = 0; i < points.size(); ++i)
+    {
+        outSectorIds[i] = FindSectorOfPoint(points[i], index);
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <raylib.h>
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include "Renderer/RaycastingMath.hpp"
+
+struct World;
+
+/// Uniform grid over the sectors bounding boxes, answers "which sector contains this point".
+/// Each cell lists the sectors whose box overlaps it, sorted by SectorID, and the walls of every
+/// sector are copied in flat arrays so the point in polygon tests never touch the World maps.
+struct SectorSpatialIndex
+{
+    // World revision the index was built from
+    uint64_t revision { 0 };
+    bool built { false };
+
+    Vector2 origin { 0 };
+    float inverseCellSize { 0 };
+    uint32_t columns { 0 };
+    uint32_t rows    { 0 };
+
+    // cellSectors[cellBegins[cell], cellBegins[cell + 1][ are the sectors (dense indices) of a cell
+    std::vector<uint32_t> cellBegins;
+    std::vector<uint32_t> cellSectors;
+
+    // Per sector, sorted by SectorID
+    std::vector<SectorID> sectorIds;
+    std::vector<Rectangle> sectorBounds;
+    std::vector<uint32_t> sectorWallsBegins;  // sectorsCount + 1 entries
+    std::vector<Segment> walls;
+
+    bool IsUpToDate(const World& world) const;
+};
+
+/// @brief Rebuilds index from world, the index storage is reused
+void BuildSectorSpatialIndex(const World& world, SectorSpatialIndex& index);
+
+/// @brief Sector containing point, NULL_SECTOR when none does
+/// When sectors overlap the smallest SectorID containing the point wins
+SectorID FindSectorOfPoint(Vector2 point, const SectorSpatialIndex& index);
+
+/// @brief Same as FindSectorOfPoint for every point, outSectorIds must be as long as points
+void FindSectorsOfPoints(std::span<const Vector2> points, const SectorSpatialIndex& index, std::span<SectorID> outSectorIds);
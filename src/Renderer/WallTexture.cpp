@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "Renderer/WallTexture.hpp"
+
+namespace
+{
+    WallTextureMip DownsampleWallTextureMip(const WallTextureMip& source)
+    {
+        const uint32_t width = std::max(source.width / 2, 1U);
+        const uint32_t height = std::max(source.height / 2, 1U);
+
+        WallTextureMip mip {
+            .width = width,
+            .height = height,
+            .texels = std::vector<Color>(static_cast<size_t>(width) * height),
+        };
+
+        for(uint32_t u = 0; u < mip.width; ++u)
+        {
+            // Odd sizes reuse the last source column / row
+            const Color* column0 = source.Column(std::min(2 * u, source.width - 1));
+            const Color* column1 = source.Column(std::min(2 * u + 1, source.width - 1));
+
+            for(uint32_t v = 0; v < mip.height; ++v)
+            {
+                const uint32_t v0 = std::min(2 * v, source.height - 1);
+                const uint32_t v1 = std::min(2 * v + 1, source.height - 1);
+
+                const Color texels[4] = { column0[v0], column0[v1], column1[v0], column1[v1] };
+
+                uint32_t r = 2, g = 2, b = 2, a = 2;
+                for(const Color& texel : texels)
+                {
+                    r += texel.r; g += texel.g; b += texel.b; a += texel.a;
+                }
+
+                mip.texels[static_cast<size_t>(u) * mip.height + v] = {
+                    static_cast<uint8_t>(r / 4), static_cast<uint8_t>(g / 4), static_cast<uint8_t>(b / 4), static_cast<uint8_t>(a / 4)
+                };
+            }
+        }
+
+        return mip;
+    }
+}
+
+WallTexture BuildWallTexture(std::span<const Color> rowMajorPixels, uint32_t width, uint32_t height)
+{
+    // "Image size does not match its pixels"
+    assert(rowMajorPixels.size() == static_cast<size_t>(width) * height);
+
+    WallTexture texture;
+
+    if(width == 0 || height == 0) return texture;
+
+    WallTextureMip& base = texture.mips.emplace_back(WallTextureMip {
+        .width = width,
+        .height = height,
+        .texels = std::vector<Color>(rowMajorPixels.size()),
+    });
+
+    for(uint32_t y = 0; y < height; ++y)
+    {
+        for(uint32_t x = 0; x < width; ++x)
+        {
+            base.texels[static_cast<size_t>(x) * height + y] = rowMajorPixels[static_cast<size_t>(y) * width + x];
+        }
+    }
+
+    while(texture.mips.back().width > 1 || texture.mips.back().height > 1)
+    {
+        WallTextureMip mip = DownsampleWallTextureMip(texture.mips.back());
+        texture.mips.push_back(std::move(mip));
+    }
+
+    return texture;
+}
+
+WallTexture LoadWallTexture(const char* path)
+{
+    Image image = LoadImage(path);
+
+    if(image.data == nullptr) return {};
+
+    Color* pixels = LoadImageColors(image);
+
+    WallTexture texture = BuildWallTexture(
+        std::span<const Color>(pixels, static_cast<size_t>(image.width) * image.height),
+        static_cast<uint32_t>(image.width), static_cast<uint32_t>(image.height)
+    );
+
+    UnloadImageColors(pixels);
+    UnloadImage(image);
+
+    return texture;
+}
+
+WallTexture GenerateBrickWallTexture(uint32_t size, Color brick, Color mortar)
+{
+    const uint32_t brickHeight = std::max(size / 8, 2U);
+    const uint32_t brickWidth = std::max(size / 4, 2U);
+
+    std::vector<Color> pixels(static_cast<size_t>(size) * size);
+
+    for(uint32_t y = 0; y < size; ++y)
+    {
+        const uint32_t brickRow = y / brickHeight;
+        // Every other row is shifted by half a brick
+        const uint32_t rowShift = (brickRow & 1) * (brickWidth / 2);
+
+        for(uint32_t x = 0; x < size; ++x)
+        {
+            const uint32_t shiftedX = (x + rowShift) % size;
+            const bool isMortar = (y % brickHeight == 0) || (shiftedX % brickWidth == 0);
+
+            // Bricks get a slightly different shade each
+            const uint32_t brickHash = (brickRow * 73856093U) ^ ((shiftedX / brickWidth) * 19349663U);
+            const float shade = 0.8f + 0.2f * static_cast<float>(brickHash % 16) / 15.f;
+
+            pixels[static_cast<size_t>(y) * size + x] = isMortar ? mortar : Color {
+                static_cast<uint8_t>(brick.r * shade), static_cast<uint8_t>(brick.g * shade), static_cast<uint8_t>(brick.b * shade), 255
+            };
+        }
+    }
+
+    return BuildWallTexture(pixels, size, size);
+}
+
+WallTexture LoadWallTextureSource(const WallTextureSource& source)
+{
+    if(source.path.empty()) return GenerateBrickWallTexture(source.bricksSize, source.brickColor, source.mortarColor);
+
+    return LoadWallTexture(source.path.c_str());
+}
+
+bool IsSameWallTextureSource(const WallTextureSource& a, const WallTextureSource& b)
+{
+    const auto sameColor = [](Color c0, Color c1) { return c0.r == c1.r && c0.g == c1.g && c0.b == c1.b && c0.a == c1.a; };
+
+    return a.path == b.path
+        && a.bricksSize == b.bricksSize
+        && sameColor(a.brickColor, b.brickColor)
+        && sameColor(a.mortarColor, b.mortarColor);
+}
+
+uint32_t SelectWallTextureMip(const WallTextureView& texture, float texelsPerPixel)
+{
+    if(texture.mipsCount == 0 || !(texelsPerPixel > 1)) return 0;
+
+    const uint32_t level = static_cast<uint32_t>(std::min(floorf(log2f(texelsPerPixel)), 31.f));
+    return std::min(level, texture.mipsCount - 1);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <raylib.h>
+#include <array>
+#include <string>
+#include <vector>
+#include <span>
+#include <cstdint>
+
+#include "Renderer/Palette.hpp"
+
+// World units covered by one repetition of a wall texture along the wall
+constexpr float WallTextureWorldWidth = 64;
+// Enough levels for a 32768 texels high texture
+constexpr uint32_t WallTextureMaxMips = 16;
+
+/// Where the texels of a wall texture come from, World::wallTextures only holds these
+struct WallTextureSource
+{
+    // Image file, loaded through raylib. Empty for a procedural brick texture built from the fields below.
+    std::string path;
+    uint32_t bricksSize { 64 };
+    Color brickColor  { 150, 70, 50, 255 };
+    Color mortarColor { 190, 180, 170, 255 };
+};
+
+/// One level of a wall texture.
+/// Texels are stored column-major (texels[u * height + v]) like the Framebuffer, a wall column
+/// then reads one contiguous run of texels while it writes one contiguous run of pixels.
+struct WallTextureMip
+{
+    uint32_t width  { 0 };
+    uint32_t height { 0 };
+    std::vector<Color> texels;
+
+    const Color* Column(uint32_t u) const { return texels.data() + static_cast<size_t>(u) * height; }
+};
+
+/// Wall texture and its mip chain, mips[0] is the source image and every next level halves
+/// both sizes down to 1x1. The texture height covers a full height wall, from z 0 to z 1.
+struct WallTexture
+{
+    std::vector<WallTextureMip> mips;
+};
+
+/// Mip level stored by someone else (see WallTextureCache), columns are columnStride texels apart
+struct WallTextureMipView
+{
+    const Color* texels { nullptr };
+    // Palette entries of the texels with the same layout, nullptr when they were not matched to a palette
+    const PaletteIndex* indices { nullptr };
+    uint32_t width  { 0 };
+    uint32_t height { 0 };
+    uint32_t columnStride { 0 };
+
+    const Color* Column(uint32_t u) const { return texels + static_cast<size_t>(u) * columnStride; }
+    const PaletteIndex* IndexColumn(uint32_t u) const { return indices + static_cast<size_t>(u) * columnStride; }
+};
+
+/// What the rasterizer reads, mipsCount is 0 while the texels are not loaded
+struct WallTextureView
+{
+    std::array<WallTextureMipView, WallTextureMaxMips> mips;
+    uint32_t mipsCount { 0 };
+};
+
+/// @brief Builds the column-major mip chain of a row-major image, each level is a 2x2 box filter of the previous one
+WallTexture BuildWallTexture(std::span<const Color> rowMajorPixels, uint32_t width, uint32_t height);
+/// @brief Loads an image file through raylib, the texture has no mips when the file can't be read
+WallTexture LoadWallTexture(const char* path);
+/// @brief size x size procedural brick pattern
+WallTexture GenerateBrickWallTexture(uint32_t size, Color brick, Color mortar);
+/// @brief Image file or procedural texture, depending on source.path
+WallTexture LoadWallTextureSource(const WallTextureSource& source);
+bool IsSameWallTextureSource(const WallTextureSource& a, const WallTextureSource& b);
+
+/// @brief Level whose texels are the closest to one per screen pixel without going under it
+/// @param texelsPerPixel texels of mips[0] covered by one screen pixel
+uint32_t SelectWallTextureMip(const WallTextureView& texture, float texelsPerPixel);
@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+#include "Renderer/WallTextureCache.hpp"
+
+namespace
+{
+    bool IsTextureRequested(std::span<const uint64_t> requestedTextures, WallTextureID textureId)
+    {
+        return (textureId >> 6) < requestedTextures.size() && ((requestedTextures[textureId >> 6] >> (textureId & 63)) & 1);
+    }
+
+    // Columns taken by a texture and its mips side by side
+    uint32_t MipChainColumns(uint32_t width, uint32_t height)
+    {
+        uint32_t columns = width;
+
+        while(width > 1 || height > 1)
+        {
+            width = std::max(width / 2, 1U);
+            height = std::max(height / 2, 1U);
+            columns += width;
+        }
+
+        return columns;
+    }
+
+    bool FitsInAtlas(uint32_t width, uint32_t height)
+    {
+        return width <= WallTextureAtlasHeight && height <= WallTextureAtlasHeight;
+    }
+
+    size_t BlockBytes(uint32_t columns, uint32_t columnStride)
+    {
+        return static_cast<size_t>(columns) * columnStride * sizeof(Color);
+    }
+
+    // Bytes the texture adds to the cache, 0 when it fits in the open atlas page
+    size_t TextureBytesToLoad(const WallTextureCache& cache, uint32_t width, uint32_t height)
+    {
+        const uint32_t columns = MipChainColumns(width, height);
+
+        if(!FitsInAtlas(width, height)) return BlockBytes(columns, height);
+
+        if(cache.openAtlasPage != NULL_WALL_TEXTURE_BLOCK && cache.blocks[cache.openAtlasPage].usedColumns + columns <= WallTextureAtlasWidth)
+        {
+            return 0;
+        }
+
+        return BlockBytes(WallTextureAtlasWidth, WallTextureAtlasHeight);
+    }
+
+    void UnloadTexture(WallTextureCache& cache, WallTextureID textureId)
+    {
+        cache.views[textureId] = {};
+        cache.textureBlocks[textureId] = NULL_WALL_TEXTURE_BLOCK;
+        --cache.residentTexturesCount;
+    }
+
+    void EvictBlock(WallTextureCache& cache, uint32_t blockIndex)
+    {
+        WallTextureBlock& block = cache.blocks[blockIndex];
+
+        for(WallTextureID textureId : block.textures)
+        {
+            UnloadTexture(cache, textureId);
+        }
+
+        cache.residentBytes -= block.texels.size() * sizeof(Color);
+        ++cache.evictionsCount;
+
+        // Gives the memory back, that is the point of the budget
+        block = {};
+
+        if(cache.openAtlasPage == blockIndex)
+        {
+            cache.openAtlasPage = NULL_WALL_TEXTURE_BLOCK;
+        }
+    }
+
+    // Blocks used this frame are never evicted, what the others free is not always enough
+    bool IsOverBudget(const WallTextureCache& cache, size_t bytes, size_t evictableBytes)
+    {
+        return cache.residentBytes - evictableBytes + bytes > cache.budgetBytes;
+    }
+
+    // Evicts least recently used blocks until bytes more fit in the budget, blocks used this frame are kept.
+    // evictableBytes counts the bytes of the blocks not used this frame, it follows the evictions.
+    void MakeRoom(WallTextureCache& cache, size_t bytes, size_t& evictableBytes)
+    {
+        while(cache.residentBytes + bytes > cache.budgetBytes)
+        {
+            uint32_t oldestBlock = NULL_WALL_TEXTURE_BLOCK;
+
+            for(uint32_t i = 0; i < cache.blocks.size(); ++i)
+            {
+                const WallTextureBlock& block = cache.blocks[i];
+                if(block.texels.empty() || block.lastUsedFrame == cache.frame) continue;
+
+                if(oldestBlock == NULL_WALL_TEXTURE_BLOCK || block.lastUsedFrame < cache.blocks[oldestBlock].lastUsedFrame)
+                {
+                    oldestBlock = i;
+                }
+            }
+
+            // "Not enough evictable blocks, IsOverBudget must be checked first"
+            assert(oldestBlock != NULL_WALL_TEXTURE_BLOCK);
+
+            evictableBytes -= cache.blocks[oldestBlock].texels.size() * sizeof(Color);
+            EvictBlock(cache, oldestBlock);
+        }
+    }
+
+    uint32_t AllocateBlock(WallTextureCache& cache, uint32_t columns, uint32_t columnStride, bool isAtlasPage)
+    {
+        auto freeBlock = std::find_if(cache.blocks.begin(), cache.blocks.end(), [](const WallTextureBlock& block) { return block.texels.empty(); });
+
+        const auto blockIndex = static_cast<uint32_t>(freeBlock - cache.blocks.begin());
+        if(freeBlock == cache.blocks.end())
+        {
+            cache.blocks.emplace_back();
+        }
+
+        WallTextureBlock& block = cache.blocks[blockIndex];
+        block.texels.resize(static_cast<size_t>(columns) * columnStride);
+        block.indices.resize(cache.palette != nullptr ? block.texels.size() : 0);
+        block.columnStride = columnStride;
+        block.usedColumns = 0;
+        block.isAtlasPage = isAtlasPage;
+        block.lastUsedFrame = cache.frame;
+
+        cache.residentBytes += block.texels.size() * sizeof(Color);
+
+        return blockIndex;
+    }
+
+    // Texels [begin, end[ of the block to their palette entries
+    void PalettizeTexels(const WallTextureCache& cache, WallTextureBlock& block, size_t begin, size_t end)
+    {
+        for(size_t i = begin; i < end; ++i)
+        {
+            block.indices[i] = FindPaletteIndex(*cache.palette, block.texels[i]);
+        }
+    }
+
+    // Copies the mips of texture side by side from the first free column of the block
+    void StoreTexture(WallTextureCache& cache, WallTextureID textureId, const WallTexture& texture, uint32_t blockIndex)
+    {
+        WallTextureBlock& block = cache.blocks[blockIndex];
+        WallTextureView& view = cache.views[textureId];
+
+        uint32_t column = block.usedColumns;
+
+        for(const WallTextureMip& mip : texture.mips)
+        {
+            const size_t offset = static_cast<size_t>(column) * block.columnStride;
+            Color* destination = block.texels.data() + offset;
+
+            for(uint32_t u = 0; u < mip.width; ++u)
+            {
+                std::copy_n(mip.Column(u), mip.height, destination + static_cast<size_t>(u) * block.columnStride);
+            }
+
+            if(cache.palette != nullptr)
+            {
+                PalettizeTexels(cache, block, offset, offset + static_cast<size_t>(mip.width) * block.columnStride);
+            }
+
+            view.mips[view.mipsCount++] = {
+                .texels = destination,
+                .indices = (cache.palette != nullptr) ? block.indices.data() + offset : nullptr,
+                .width = mip.width,
+                .height = mip.height,
+                .columnStride = block.columnStride,
+            };
+
+            column += mip.width;
+        }
+
+        block.usedColumns = column;
+        block.lastUsedFrame = cache.frame;
+        block.textures.push_back(textureId);
+
+        cache.textureBlocks[textureId] = blockIndex;
+        cache.overBudget[textureId] = false;
+        ++cache.residentTexturesCount;
+        ++cache.loadsCount;
+    }
+
+    void LoadTexture(WallTextureCache& cache, WallTextureID textureId, size_t& evictableBytes)
+    {
+        const WallTexture texture = LoadWallTextureSource(cache.sources[textureId]);
+
+        if(texture.mips.empty() || texture.mips.size() > WallTextureMaxMips)
+        {
+            cache.loadFailed[textureId] = true;
+            return;
+        }
+
+        const uint32_t width = texture.mips[0].width;
+        const uint32_t height = texture.mips[0].height;
+        cache.widths[textureId] = width;
+        cache.heights[textureId] = height;
+
+        // Checked before evicting anything, a texture that can't fit must not flush the cache for nothing.
+        // Evicting the open atlas page makes a small texture need a new one, it is then checked again.
+        size_t bytesToLoad = TextureBytesToLoad(cache, width, height);
+        for(;;)
+        {
+            if(IsOverBudget(cache, bytesToLoad, evictableBytes))
+            {
+                cache.overBudget[textureId] = true;
+                return;
+            }
+
+            MakeRoom(cache, bytesToLoad, evictableBytes);
+
+            const size_t bytesLeftToLoad = TextureBytesToLoad(cache, width, height);
+            if(bytesLeftToLoad == bytesToLoad) break;
+
+            bytesToLoad = bytesLeftToLoad;
+        }
+
+        const uint32_t columns = MipChainColumns(width, height);
+        uint32_t blockIndex = NULL_WALL_TEXTURE_BLOCK;
+
+        if(!FitsInAtlas(width, height))
+        {
+            blockIndex = AllocateBlock(cache, columns, height, false);
+        }
+        else
+        {
+            if(cache.openAtlasPage == NULL_WALL_TEXTURE_BLOCK || cache.blocks[cache.openAtlasPage].usedColumns + columns > WallTextureAtlasWidth)
+            {
+                cache.openAtlasPage = AllocateBlock(cache, WallTextureAtlasWidth, WallTextureAtlasHeight, true);
+            }
+
+            blockIndex = cache.openAtlasPage;
+        }
+
+        // The block is used this frame from now on
+        if(cache.blocks[blockIndex].lastUsedFrame != cache.frame)
+        {
+            evictableBytes -= cache.blocks[blockIndex].texels.size() * sizeof(Color);
+        }
+
+        StoreTexture(cache, textureId, texture, blockIndex);
+    }
+}
+
+void SyncWallTextureCacheSources(WallTextureCache& cache, std::span<const WallTextureSource> sources)
+{
+    const size_t texturesCount = sources.size();
+
+    // Blocks holding a texture that changed or disappeared are dropped with all their textures
+    for(uint32_t blockIndex = 0; blockIndex < cache.blocks.size(); ++blockIndex)
+    {
+        const std::vector<WallTextureID>& textures = cache.blocks[blockIndex].textures;
+
+        const bool isOutdated = std::any_of(textures.begin(), textures.end(), [&](WallTextureID textureId) {
+            return textureId >= texturesCount || !IsSameWallTextureSource(cache.sources[textureId], sources[textureId]);
+        });
+
+        if(isOutdated)
+        {
+            EvictBlock(cache, blockIndex);
+        }
+    }
+
+    for(WallTextureID textureId = 0; textureId < std::min(texturesCount, cache.sources.size()); ++textureId)
+    {
+        if(!IsSameWallTextureSource(cache.sources[textureId], sources[textureId]))
+        {
+            cache.loadFailed[textureId] = false;
+            cache.overBudget[textureId] = false;
+            cache.widths[textureId] = cache.heights[textureId] = 0;
+        }
+    }
+
+    cache.sources.assign(sources.begin(), sources.end());
+    cache.views.resize(texturesCount);
+    cache.textureBlocks.resize(texturesCount, NULL_WALL_TEXTURE_BLOCK);
+    cache.loadFailed.resize(texturesCount, false);
+    cache.widths.resize(texturesCount, 0);
+    cache.heights.resize(texturesCount, 0);
+    cache.overBudget.resize(texturesCount, false);
+}
+
+void UpdateWallTextureCache(WallTextureCache& cache, std::span<const uint64_t> requestedTextures)
+{
+    ++cache.frame;
+    cache.pendingLoadsCount = 0;
+
+    // Touched first, so loads below never evict what the frame is about to draw
+    for(WallTextureID textureId = 0; textureId < cache.views.size(); ++textureId)
+    {
+        if(cache.textureBlocks[textureId] != NULL_WALL_TEXTURE_BLOCK && IsTextureRequested(requestedTextures, textureId))
+        {
+            cache.blocks[cache.textureBlocks[textureId]].lastUsedFrame = cache.frame;
+        }
+    }
+
+    // Kept up to date by the loads, so over budget textures are told apart without going over the blocks again
+    size_t evictableBytes = 0;
+    for(const WallTextureBlock& block : cache.blocks)
+    {
+        if(block.lastUsedFrame != cache.frame) evictableBytes += block.texels.size() * sizeof(Color);
+    }
+
+    uint32_t loadsCount = 0;
+
+    for(WallTextureID textureId = 0; textureId < cache.views.size(); ++textureId)
+    {
+        if(cache.textureBlocks[textureId] != NULL_WALL_TEXTURE_BLOCK || cache.loadFailed[textureId]
+            || !IsTextureRequested(requestedTextures, textureId))
+        {
+            continue;
+        }
+
+        // Known size, the texture is only read from disk when there is room for it
+        if(cache.widths[textureId] != 0)
+        {
+            cache.overBudget[textureId] = IsOverBudget(cache, TextureBytesToLoad(cache, cache.widths[textureId], cache.heights[textureId]), evictableBytes);
+
+            if(cache.overBudget[textureId]) continue;
+        }
+
+        if(loadsCount == MaxWallTextureLoadsPerUpdate)
+        {
+            ++cache.pendingLoadsCount;
+            continue;
+        }
+
+        LoadTexture(cache, textureId, evictableBytes);
+        ++loadsCount;
+    }
+}
+
+void SetWallTextureCachePalette(WallTextureCache& cache, const Palette* palette)
+{
+    cache.palette = palette;
+
+    for(WallTextureBlock& block : cache.blocks)
+    {
+        if(block.texels.empty()) continue;
+
+        block.indices.resize(palette != nullptr ? block.texels.size() : 0);
+
+        if(palette != nullptr)
+        {
+            PalettizeTexels(cache, block, 0, static_cast<size_t>(block.usedColumns) * block.columnStride);
+        }
+
+        for(WallTextureID textureId : block.textures)
+        {
+            WallTextureView& view = cache.views[textureId];
+
+            for(uint32_t mip = 0; mip < view.mipsCount; ++mip)
+            {
+                view.mips[mip].indices = (palette != nullptr) ? block.indices.data() + (view.mips[mip].texels - block.texels.data()) : nullptr;
+            }
+        }
+    }
+}
+
+bool HasMissingWallTextures(const WallTextureCache& cache, std::span<const uint64_t> requestedTextures)
+{
+    for(size_t word = 0; word < requestedTextures.size(); ++word)
+    {
+        for(uint64_t bits = requestedTextures[word]; bits != 0; bits &= bits - 1)
+        {
+            const auto textureId = static_cast<WallTextureID>(word * 64 + std::countr_zero(bits));
+
+            if(textureId < cache.views.size() && cache.textureBlocks[textureId] == NULL_WALL_TEXTURE_BLOCK
+                && !cache.loadFailed[textureId] && !cache.overBudget[textureId])
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Renderer/RaycastingMath.hpp"
+#include "Renderer/WallTexture.hpp"
+
+// Texel bytes the cache keeps resident by default
+constexpr size_t DefaultWallTextureCacheBudget = size_t(64) << 20;
+// Textures whose mip 0 fits in WallTextureAtlasHeight x WallTextureAtlasHeight are packed in atlas pages
+constexpr uint32_t WallTextureAtlasHeight = 64;
+constexpr uint32_t WallTextureAtlasWidth = 2048;
+// Loads done by one UpdateWallTextureCache, the other missing textures wait for the next frames
+constexpr uint32_t MaxWallTextureLoadsPerUpdate = 4;
+
+constexpr uint32_t NULL_WALL_TEXTURE_BLOCK { static_cast<uint32_t>(-1) };
+
+/// Texels owned by the cache, the eviction unit.
+/// A block holds either one texture or an atlas page of small ones. Textures are stored column-major
+/// with their mips side by side, so a texture column stays one contiguous run of texels in both cases.
+struct WallTextureBlock
+{
+    std::vector<Color> texels;
+    // Palette entries of texels, same layout. Empty while the cache has no palette.
+    std::vector<PaletteIndex> indices;
+    // Texels per column, the height of the block
+    uint32_t columnStride { 0 };
+    // Atlas pages are filled left to right, standalone textures use all their columns
+    uint32_t usedColumns  { 0 };
+    bool isAtlasPage { false };
+    uint64_t lastUsedFrame { 0 };
+    std::vector<WallTextureID> textures;
+};
+
+/// Wall textures loaded on demand, kept under budgetBytes by evicting the least recently used blocks.
+/// It is only updated between frames, the rasterizer reads views during the frame and records
+/// the textures of the sectors it visits, see UpdateWallTextureCache.
+struct WallTextureCache
+{
+    // Counts the texels only, blocks matched to a palette take a quarter more for their indices
+    size_t budgetBytes { DefaultWallTextureCacheBudget };
+    size_t residentBytes { 0 };
+    uint64_t frame { 0 };
+
+    // Textures are matched to it once when stored, so palettized frames read indices. nullptr until set.
+    const Palette* palette { nullptr };
+
+    // Copy of World::wallTextures, indexed by WallTextureID like the vectors below
+    std::vector<WallTextureSource> sources;
+    std::vector<WallTextureView> views;
+    std::vector<uint32_t> textureBlocks;
+    // Failed loads are not retried until their source changes
+    std::vector<bool> loadFailed;
+    // Mip 0 size once loaded a first time, lets a texture known to not fit be skipped without loading it
+    std::vector<uint32_t> widths;
+    std::vector<uint32_t> heights;
+    // Did not fit in the budget next to the other requested textures at the last update
+    std::vector<bool> overBudget;
+
+    // Evicted blocks are left empty and reused
+    std::vector<WallTextureBlock> blocks;
+    // Atlas page new small textures go to
+    uint32_t openAtlasPage { NULL_WALL_TEXTURE_BLOCK };
+
+    // Requested textures the last update could not load, because of MaxWallTextureLoadsPerUpdate
+    uint32_t pendingLoadsCount { 0 };
+    uint32_t residentTexturesCount { 0 };
+    uint64_t loadsCount { 0 };
+    uint64_t evictionsCount { 0 };
+};
+
+/// @brief Follows World::wallTextures, the textures whose source changed are unloaded
+void SyncWallTextureCacheSources(WallTextureCache& cache, std::span<const WallTextureSource> sources);
+
+/// @brief Marks the requested textures as used and loads the missing ones, evicting the blocks
+/// unused for the longest time when the budget is reached. Blocks used by the requested textures
+/// are never evicted, a texture that does not fit next to them stays unloaded.
+/// @param requestedTextures bitset of the WallTextureIDs the last frame visited
+void UpdateWallTextureCache(WallTextureCache& cache, std::span<const uint64_t> requestedTextures);
+
+/// @brief Matches the texels of every resident texture to palette, and the ones stored later.
+/// To be called again whenever the palette changes, nullptr drops the indices.
+void SetWallTextureCachePalette(WallTextureCache& cache, const Palette* palette);
+
+/// @brief True when some requested texture is still to be loaded, failed and over budget ones excluded
+bool HasMissingWallTextures(const WallTextureCache& cache, std::span<const uint64_t> requestedTextures);
@@ -1,5 +1,7 @@
 #include "World.hpp"
 
+#include <cassert>
+
 World::World()
 {
     InitWorld();
@@ -11,6 +13,17 @@ void World::InitWorld()
     {
         RearrangeWallListToPolygon(sector.walls);
     }
+
+    MarkModified();
+    UpdateSpatialIndex();
+}
+
+void World::UpdateSpatialIndex()
+{
+    if(!spatialIndex.IsUpToDate(*this))
+    {
+        BuildSectorSpatialIndex(*this, spatialIndex);
+    }
 }
 
 void RearrangeWallListToPolygon(std::vector<Wall> &walls)
@@ -30,6 +43,11 @@ void RearrangeWallListToPolygon(std::vector<Wall> &walls)
 
 uint32_t FindSectorOfPoint(Vector2 point, const World &world)
 {
+    if(world.spatialIndex.IsUpToDate(world))
+    {
+        return FindSectorOfPoint(point, world.spatialIndex);
+    }
+
     for(const auto& [ sectorId, sector ] : world.Sectors)
     {
         if(IsPointInSector(point, sector))
@@ -39,4 +57,88 @@ uint32_t FindSectorOfPoint(Vector2 point, const World &world)
     }
 
     return NULL_SECTOR;
+}
+
+void FindSectorsOfPoints(std::span<const Vector2> points, const World& world, std::span<SectorID> outSectorIds)
+{
+    if(world.spatialIndex.IsUpToDate(world))
+    {
+        FindSectorsOfPoints(points, world.spatialIndex, outSectorIds);
+        return;
+    }
+
+    // "outSectorIds must hold one entry per point"
+    assert(points.size() == outSectorIds.size());
+
+    for(size_t i = 0; i < points.size(); ++i)
+    {
+        outSectorIds[i] = FindSectorOfPoint(points[i], world);
+    }
+}
+
+SectorID TrackSectorOfMovingPoint(SectorID fromSector, Vector2 from, Vector2 to, const World& world)
+{
+    // Stop following portals after that many sectors, a move that long is handled like a teleport
+    constexpr uint32_t MaxCrossedPortals = 64;
+
+    const auto fallback = [&]()
+    {
+        const SectorID foundSectorId = FindSectorOfPoint(to, world);
+        return foundSectorId != NULL_SECTOR ? foundSectorId : fromSector;
+    };
+
+    auto sectorIt = world.Sectors.find(fromSector);
+    if(sectorIt == world.Sectors.end())
+    {
+        return fallback();
+    }
+
+    SectorID sectorId = fromSector;
+    SectorID previousSectorId = NULL_SECTOR;
+    float moveT = 0;
+
+    for(uint32_t crossedPortals = 0; crossedPortals <= MaxCrossedPortals; ++crossedPortals)
+    {
+        const Sector& sector = sectorIt->second;
+
+        // First wall crossed after entering this sector, the portal we came through is skipped
+        const Wall* crossedWall = nullptr;
+        float crossedT = INFINITY;
+
+        for(const Wall& wall : sector.walls)
+        {
+            if(previousSectorId != NULL_SECTOR && wall.toSector == previousSectorId)
+                continue;
+
+            float t;
+            if(MoveToSegmentCollision(from, to, wall.segment, t) && t >= moveT && t < crossedT)
+            {
+                crossedWall = &wall;
+                crossedT = t;
+            }
+        }
+
+        if(crossedWall == nullptr)
+        {
+            // Sanity check against float precision issues around wall ends, still only this sector walls
+            return IsPointInSector(to, sector) ? sectorId : fallback();
+        }
+
+        if(crossedWall->toSector == NULL_SECTOR)
+        {
+            return fallback();
+        }
+
+        sectorIt = world.Sectors.find(crossedWall->toSector);
+        if(sectorIt == world.Sectors.end())
+        {
+            return fallback();
+        }
+
+        previousSectorId = sectorId;
+        sectorId = crossedWall->toSector;
+        moveT = crossedT;
+    }
+
+    return fallback();
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <unordered_map>
+#include <span>
 
 #include "RaycastingMath.hpp"
+#include "SectorSpatialIndex.hpp"
+#include "WallTexture.hpp"
 
 struct World
 {
@@ -21,14 +24,17 @@ struct World
                     {
                         .segment = { { 500, 600 }, { 300, 600 } }, 
                         .color = WHITE,
+                        .texture = 0,
                     },
                     {
                         .segment = { { 300, 600 }, { 300, 700 } }, 
                         .color = WHITE,
+                        .texture = 0,
                     },
                     {
                         .segment = { { 300, 700 }, { 500, 700 } }, 
                         .color = WHITE,
+                        .texture = 0,
                     },
                 },
                 .zFloor = 0.95
@@ -65,10 +71,12 @@ struct World
                     { 
                         .segment = { { 700, 700 }, { 700, 500 } }, 
                         .color = WHITE,
+                        .texture = 0,
                     },
                     {
                         .segment = { { 700, 500 }, { 500, 500 } }, 
                         .color = WHITE,
+                        .texture = 0,
                     },
                     {
                         .segment = { { 700, 700 }, { 500, 500 } },
@@ -83,8 +91,27 @@ struct World
         },
     };
 
+    // Referenced by Wall::texture, changing them must go with MarkModified.
+    // Only the sources live here, the texels are loaded on demand by the rasterizer WallTextureCache.
+    std::vector<WallTextureSource> wallTextures = { WallTextureSource {} };
+
+    // Incremented on every change so data derived from the world (RenderWorld, ...) knows when to rebuild
+    uint64_t revision { 0 };
+
+    // Point to sector lookup acceleration, rebuilt by UpdateSpatialIndex once revision moved on
+    SectorSpatialIndex spatialIndex;
+
     void InitWorld();
+    void MarkModified() { ++revision; }
+    void UpdateSpatialIndex();
 };
 
 void RearrangeWallListToPolygon(std::vector<Wall>& walls);
-uint32_t FindSectorOfPoint(Vector2 point, const World& world);
\ No newline at end of file
+// Use the spatial index when it is up to date, scan every sector otherwise
+uint32_t FindSectorOfPoint(Vector2 point, const World& world);
+void FindSectorsOfPoints(std::span<const Vector2> points, const World& world, std::span<SectorID> outSectorIds);
+
+// Sector reached by a point moving from "from" (inside fromSector) to "to", following the portals crossed on the way
+// so only the walls of the traversed sectors are tested, falls back to FindSectorOfPoint when
+// the move goes through a solid wall (teleports, no clip) or fromSector is not valid anymore
+SectorID TrackSectorOfMovingPoint(SectorID fromSector, Vector2 from, Vector2 to, const World& world);
\ No newline at end of file
@@ -1,320 +1,1829 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <limits>
 #include <iostream>
-#include <unordered_map>
+#include <tuple>
 #include <vector>
 
 #include "Renderer/WorldRasterizer.hpp"
 #include "Renderer/RaycastingMath.hpp"
+#include "Renderer/RaycastingMathSimd.hpp"
 #include "Utils/ColorHelper.hpp"
+#include "Utils/AllocationCounter.hpp"
+#include "Utils/JobSystem.hpp"
 #include "WorldRasterizer.hpp"
 
 void RasterizeInRenderArea(RasterizeWorldContext& ctx, SectorRenderContext renderContext)
 {
-    std::unordered_map<SectorID, SectorRenderContext> renderAreaToPushInStack;
+    const SectorIndex sectorIndex = renderContext.sectorIndex;
+    RenderArea renderArea = renderContext.renderArea;
 
-    const auto& [ sectorId, renderArea ] = renderContext;
-    
-    const Sector& currentSector = ctx.world->Sectors.at(sectorId);
-
-    for(uint32_t x = renderArea.xBegin; x <= renderArea.xEnd; ++x)
+    // Columns may have been closed since the area was pushed, nothing is left to do when all are
+    if(!TrimRenderAreaToOpenColumns(ctx, renderArea))
     {
-        MinMaxUint32& yMinMax = ctx.yBoundaries.at(x);
+        ScheduleRenderAreas(ctx, {});
+        return;
+    }
 
-        float rayAngle = RayAngleForScreenXCam(x, *ctx.cam, ctx.RenderTargetWidth);
+    RequestSectorWallTextures(ctx, sectorIndex);
 
-        RasterRay rasterRay = {
-            .position = ctx.cam->position,
-            .direction = Vector2DirectionFromAngle((rayAngle * DEG2RAD) + ctx.cam->yaw),
-        };
+    const FrameArena::Marker arenaMarker = ctx.frameArena.GetMarker();
 
-        struct RaycastHitData
-        {
-            float distance = std::numeric_limits<float>::max();
-            Vector2 position;
-            const Wall* wall = nullptr;
-        } bestHitData;
+    NextRenderAreas renderAreaToPushInStack {
+        .areas = ctx.frameArena.Allocate<SectorRenderContext>(renderArea.xEnd - renderArea.xBegin + 1),
+        .areaSlots = ctx.nextAreaSlots,
+    };
+
+    // Columns the visit does not rasterize keep empty plane spans
+    ctx.ceilingSpans = ctx.frameArena.Allocate<MinMaxUint32>(renderArea.xEnd - renderArea.xBegin + 1);
+    ctx.floorSpans = ctx.frameArena.Allocate<MinMaxUint32>(renderArea.xEnd - renderArea.xBegin + 1);
+    ctx.planeSpansXBegin = renderArea.xBegin;
+    std::fill(ctx.ceilingSpans.begin(), ctx.ceilingSpans.end(), MinMaxUint32 {});
+    std::fill(ctx.floorSpans.begin(), ctx.floorSpans.end(), MinMaxUint32 {});
+
+    // Ray mode per column searches in big sectors go through the wall BVH, which needs no per visit culling
+    const bool useWallBvh = ctx.mode == RasterizationMode::Ray && ctx.world->sectors[sectorIndex].wallBvhRoot != NULL_WALL_BVH_NODE;
 
-        for(const Wall& wall : currentSector.walls)
+    const VisibleWalls visibleWalls = useWallBvh ? VisibleWalls {} : CullSectorWalls(ctx, sectorIndex, renderArea);
+
+    switch(ctx.mode)
+    {
+        case RasterizationMode::Ray:
         {
-            HitInfo hitInfo;
-            if(RayToSegmentCollision(rasterRay, wall.segment, hitInfo))
+            if(useWallBvh)
             {
-                if(wall.toSector != NULL_SECTOR 
-                    && PointSegmentSide(ctx.cam->position, wall.segment.a, wall.segment.b) <= 0)
+                for(uint32_t x = renderArea.xBegin; x <= renderArea.xEnd; x = NextOpenColumn(ctx, x + 1, renderArea.xEnd))
                 {
-                    continue;
-                }
+                    if(ctx.columnSectors[x] != sectorIndex) continue;
 
-                if(bestHitData.distance > hitInfo.distance)
-                {
-                    bestHitData = {
-                        .distance = hitInfo.distance,
-                        .position = hitInfo.position,
-                        .wall = &wall,
-                    };
+                    RaycastHitData bestHitData = FindNearestWallHitBvh(ctx, sectorIndex, ComputeColumnRay(ctx, x));
+                    RasterizeColumnHit(ctx, sectorIndex, x, bestHitData, renderAreaToPushInStack);
                 }
+
+                break;
+            }
+
+            const VisibleWallsDepthOrder depthOrder = SortVisibleWallsByDepth(ctx, visibleWalls);
+            uint32_t coherentWall = NULL_VISIBLE_WALL;
+
+            for(uint32_t x = renderArea.xBegin; x <= renderArea.xEnd; x = NextOpenColumn(ctx, x + 1, renderArea.xEnd))
+            {
+                if(ctx.columnSectors[x] != sectorIndex) continue;
+
+                RaycastHitData bestHitData = FindNearestWallHitCoherent(ctx, visibleWalls, depthOrder, ComputeColumnRay(ctx, x), coherentWall);
+                RasterizeColumnHit(ctx, sectorIndex, x, bestHitData, renderAreaToPushInStack);
             }
         }
+        break;
 
-        if(bestHitData.distance < std::numeric_limits<float>::max())
+        case RasterizationMode::SimdBatch:
         {
-            // Floor / ceiling rendering
+            for(uint32_t x = renderArea.xBegin; x <= renderArea.xEnd; x = NextOpenColumn(ctx, x + 1, renderArea.xEnd))
             {
-                // // Draw floor
-                // float centerY = ((RenderTargetHeight / 2) - FloorVerticalOffset) + CamCurrentSectorElevationOffset;
-                // DrawLine(x, yMinMax.min, x, centerY, currentSector.ceilingColor);
-                // // Draw Ceiling
-                // DrawLine(x, centerY, x, yMinMax.max, currentSector.floorColor);
+                if(ctx.columnSectors[x] != sectorIndex) continue;
+
+                RaycastHitData bestHitData = FindNearestWallHitSimd(visibleWalls, ComputeColumnRay(ctx, x));
+                RasterizeColumnHit(ctx, sectorIndex, x, bestHitData, renderAreaToPushInStack);
             }
+        }
+        break;
 
-            // Means this is a slid wall
-            if(bestHitData.wall->toSector == NULL_SECTOR)
+        case RasterizationMode::RayPacket:
+        {
+            for(uint32_t x = renderArea.xBegin; x <= renderArea.xEnd; x += RayPacketSize)
             {
-                CameraYLineData cameraWallYData = 
-                    ComputeCameraYAxis(*ctx.cam, x, bestHitData.distance, 
-                        ctx.FloorVerticalOffset, ctx.CamCurrentSectorElevationOffset,
-                        ctx.RenderTargetWidth, ctx.RenderTargetHeight,
-                        yMinMax.max,
-                        yMinMax.min,
-                        currentSector.zFloor, currentSector.zCeiling
-                    );
-
-                RenderCameraYLine(cameraWallYData, bestHitData.wall->color);
+                const uint32_t lanesCount = std::min(RayPacketSize, renderArea.xEnd - x + 1);
+                RasterizeRayPacket(ctx, sectorIndex, visibleWalls, x, lanesCount, renderAreaToPushInStack);
             }
-            else
-            {
-                // "Try to render a next sector with an invalid SectorID"
-                assert(ctx.world->Sectors.contains(bestHitData.wall->toSector));
-
-                const SectorID nextSectorId = bestHitData.wall->toSector;
-                const Sector& nextSector = ctx.world->Sectors.at(nextSectorId);
-                
-                RenderNextAreaBorders(ctx, yMinMax, currentSector, nextSector, x, bestHitData.distance);
+        }
+        break;
 
-                // Create / update NextRenderArea
+        case RasterizationMode::WallSpan:
+        {
+            std::span<RaycastHitData> columnHits = ctx.frameArena.Allocate<RaycastHitData>(renderArea.xEnd - renderArea.xBegin + 1);
+            ProjectWallSpansInRenderArea(ctx, visibleWalls, renderArea, columnHits);
 
-                if(!renderAreaToPushInStack.contains(nextSectorId))
-                {
-                    SectorRenderContext nextRenderAreaContext = {
-                        .sectorId = nextSectorId,
-                        .renderArea = {
-                            .xBegin = x,
-                            .xEnd = x
-                        },
-                    };
+            for(uint32_t x = renderArea.xBegin; x <= renderArea.xEnd; x = NextOpenColumn(ctx, x + 1, renderArea.xEnd))
+            {
+                if(ctx.columnSectors[x] != sectorIndex) continue;
 
-                    renderAreaToPushInStack.emplace(nextSectorId, nextRenderAreaContext);
-                }
-                else
-                {
-                    renderAreaToPushInStack.at(nextSectorId).renderArea.xEnd = x;
-                }
-            
-                // Draw a Purple placeholder where next sector will be drawn
-                DrawLineV({(float)x, (float)yMinMax.min}, { (float)x, (float)yMinMax.max }, PURPLE);
+                RasterizeColumnHit(ctx, sectorIndex, x, columnHits[x - renderArea.xBegin], renderAreaToPushInStack);
             }
         }
+        break;
     }
 
-    // current render is over pop it
-    ctx.renderStack.pop();
+    DrawSectorPlanes(ctx, sectorIndex, renderArea);
+
+    const std::span<SectorRenderContext> nextAreas = renderAreaToPushInStack.areas.first(renderAreaToPushInStack.areasCount);
 
-    for(const auto& [ key, renderAreaCtx ] : renderAreaToPushInStack)
+    for(SectorRenderContext& renderAreaCtx : nextAreas)
     {
-        ctx.renderStack.push(renderAreaCtx);
+        renderAreaCtx.depth = renderContext.depth + 1;
+        ctx.nextAreaSlots[renderAreaCtx.sectorIndex] = NULL_AREA_SLOT;
     }
+
+    // The portals crossed by each column are bounded by maxPortalDepth, the frame is the same however its visits are split
+    const bool isDepthBudgetReached = renderContext.depth + 1 >= ctx.cam->maxPortalDepth;
+
+    // current render is over replace it by the next ones
+    ScheduleRenderAreas(ctx, isDepthBudgetReached ? std::span<const SectorRenderContext> {} : nextAreas);
+
+    ctx.frameArena.Rewind(arenaMarker);
 }
 
-void RenderNextAreaBorders(RasterizeWorldContext& worldContext, MinMaxUint32& yMinMax, const Sector& currentSector, const Sector& nextSector, uint32_t x, float hitDistance)
+void ScheduleRenderAreas(RasterizeWorldContext& ctx, std::span<const SectorRenderContext> nextAreas)
 {
-    // TODO : 
-    // zCeilling shloud not be < to current zFloor
-    // And this is the same in the other way
-    // zFloor should not be > to current zCeiling
- 
-    // Top Border
+    // The visited area is at the back
+    ctx.renderStack.pop_back();
+
+    switch(ctx.scheduler)
     {
-        bool nextSectCelingHigher = nextSector.zCeiling >= currentSector.zCeiling;
+        case RenderAreaScheduler::DepthFirst:
+        {
+            ctx.renderStack.insert(ctx.renderStack.end(), nextAreas.begin(), nextAreas.end());
+        }
+        break;
 
-        const Sector& zSizesSector = (nextSectCelingHigher) ? currentSector : nextSector;
+        case RenderAreaScheduler::BreadthFirst:
+        {
+            // Areas never share a column, so xBegin tells apart any two areas and the order is total
+            const auto isVisitedAfter = [](const SectorRenderContext& a, const SectorRenderContext& b)
+            {
+                return std::tie(a.depth, a.nearestDistance, a.renderArea.xBegin) 
+                    > std::tie(b.depth, b.nearestDistance, b.renderArea.xBegin);
+            };
 
-        CameraYLineData topBorderLineData = ComputeCameraYAxis(*worldContext.cam, x, hitDistance, 
-            worldContext.FloorVerticalOffset, worldContext.CamCurrentSectorElevationOffset,
-            worldContext.RenderTargetWidth, worldContext.RenderTargetHeight,
-            yMinMax.max, yMinMax.min,
-            0, zSizesSector.zCeiling
-        );
+            // Everything but the back is a heap, pop_heap then moves the area to visit next at the back
+            for(const SectorRenderContext& nextArea : nextAreas)
+            {
+                ctx.renderStack.push_back(nextArea);
+                std::push_heap(ctx.renderStack.begin(), ctx.renderStack.end(), isVisitedAfter);
+            }
 
-        if(!nextSectCelingHigher)
-        {
-            bool topEdge = !nextSectCelingHigher;
-            RenderCameraYLine(topBorderLineData, nextSector.topBorderColor, topEdge, true);
+            if(!ctx.renderStack.empty())
+            {
+                std::pop_heap(ctx.renderStack.begin(), ctx.renderStack.end(), isVisitedAfter);
+            }
         }
-
-        // Apply Y min
-        yMinMax.min = topBorderLineData.bottom.y;
+        break;
     }
+}
 
-    // Bottom Border
+RasterRay ComputeColumnRay(const RasterizeWorldContext& ctx, uint32_t x)
+{
+    return {
+        .position = ctx.cam->position,
+        .direction = ctx.projection->rayDirections[x],
+    };
+}
+
+VisibleWalls CullSectorWalls(RasterizeWorldContext& ctx, SectorIndex sectorIndex, RenderArea renderArea)
+{
+    const RenderWorld& world = *ctx.world;
+    const RenderSector& sector = world.sectors[sectorIndex];
+
+    VisibleWalls visibleWalls {
+        .wallIndices = ctx.frameArena.Allocate<WallIndex>(sector.wallsCount),
+        .columnSpans = ctx.frameArena.Allocate<WallColumnSpans>(sector.wallsCount),
+        // Filled once the visible walls are known
+        .walls = {},
+    };
+
+    uint32_t visibleWallsCount = 0;
+
+    for(WallIndex wallIndex = sector.wallsBegin; wallIndex < sector.wallsBegin + sector.wallsCount; ++wallIndex)
     {
-        bool nextSectFloorHigher = nextSector.zFloor >= currentSector.zFloor;
+        const Segment segment = world.WallSegment(wallIndex);
 
-        const Sector& zSizesSector = (nextSectFloorHigher) ? currentSector : nextSector;
+        // Portals seen from behind never win a column
+        if(world.wallToSector[wallIndex] != NULL_SECTOR_INDEX 
+            && PointSegmentSide(ctx.cam->position, segment.a, segment.b) <= 0)
+        {
+            continue;
+        }
 
-        CameraYLineData bottomBorderLineData = ComputeCameraYAxis(*worldContext.cam, x, hitDistance, 
-            worldContext.FloorVerticalOffset, worldContext.CamCurrentSectorElevationOffset,
-            worldContext.RenderTargetWidth, worldContext.RenderTargetHeight,
-            yMinMax.max, yMinMax.min,
-            zSizesSector.zFloor, 0
-        );
+        // Neither do portals the camera sector can't see, they are behind nearer walls for every ray
+        if(world.wallToSector[wallIndex] != NULL_SECTOR_INDEX
+            && !world.IsSectorPotentiallyVisible(ctx.camSectorIndex, world.wallToSector[wallIndex]))
+        {
+            continue;
+        }
 
-        if(!nextSectFloorHigher)
+        // Walls outside the render area view wedge can't be hit by its rays
+        RenderArea wallSpans[2];
+        const uint32_t wallSpansCount = ProjectSegmentToScreenColumns(*ctx.cam, ctx.RenderTargetWidth, segment, wallSpans);
+
+        WallColumnSpans& columnSpans = visibleWalls.columnSpans[visibleWallsCount];
+        columnSpans.spansCount = 0;
+
+        for(uint32_t i = 0; i < wallSpansCount; ++i)
         {
-            bool bottomEdge = !nextSectFloorHigher;
-            RenderCameraYLine(bottomBorderLineData, nextSector.bottomBorderColor, true, bottomEdge);
+            const uint32_t xBegin = std::max(wallSpans[i].xBegin, renderArea.xBegin);
+            const uint32_t xEnd = std::min(wallSpans[i].xEnd, renderArea.xEnd);
+
+            if(xBegin > xEnd) continue;
+
+            columnSpans.spans[columnSpans.spansCount++] = { .xBegin = xBegin, .xEnd = xEnd };
         }
 
-        // Apply Y max
-        yMinMax.max = bottomBorderLineData.top.y;
+        if(columnSpans.spansCount == 0) continue;
+
+        visibleWalls.wallIndices[visibleWallsCount++] = wallIndex;
+    }
+
+    visibleWalls.wallIndices = visibleWalls.wallIndices.first(visibleWallsCount);
+    visibleWalls.columnSpans = visibleWalls.columnSpans.first(visibleWallsCount);
+
+    // Zero length padding walls, like the RenderWorld ones
+    const size_t paddedCount = PaddedWallsCount(visibleWallsCount);
+
+    std::span<float> ax = ctx.frameArena.Allocate<float>(paddedCount);
+    std::span<float> ay = ctx.frameArena.Allocate<float>(paddedCount);
+    std::span<float> bx = ctx.frameArena.Allocate<float>(paddedCount);
+    std::span<float> by = ctx.frameArena.Allocate<float>(paddedCount);
+    std::span<uint32_t> toSector = ctx.frameArena.Allocate<uint32_t>(paddedCount);
+
+    for(size_t i = 0; i < paddedCount; ++i)
+    {
+        const bool isPadding = (i >= visibleWallsCount);
+        const WallIndex wallIndex = isPadding ? NULL_WALL_INDEX : visibleWalls.wallIndices[i];
+
+        ax[i] = isPadding ? 0.f : world.wallAx[wallIndex];
+        ay[i] = isPadding ? 0.f : world.wallAy[wallIndex];
+        bx[i] = isPadding ? 0.f : world.wallBx[wallIndex];
+        by[i] = isPadding ? 0.f : world.wallBy[wallIndex];
+        toSector[i] = isPadding ? NULL_SECTOR_INDEX : world.wallToSector[wallIndex];
     }
+
+    visibleWalls.walls = {
+        .ax = ax.data(),
+        .ay = ay.data(),
+        .bx = bx.data(),
+        .by = by.data(),
+        .toSector = toSector.data(),
+        .count = visibleWallsCount,
+        .paddedCount = paddedCount,
+    };
+
+    return visibleWalls;
 }
 
-float ComputeVerticalOffset(const RaycastingCamera& cam, uint32_t RenderTargetHeight)
+VisibleWallsDepthOrder SortVisibleWallsByDepth(RasterizeWorldContext& ctx, const VisibleWalls& visibleWalls)
 {
-    return round(0.5f * RenderTargetHeight * (tanf(cam.pitch)) / tanf(0.5f * cam.fovVectical));
-}
+    const size_t visibleWallsCount = visibleWalls.wallIndices.size();
 
-float ComputeElevationOffset(const RaycastingCamera& cam, const World& world, uint32_t RenderTargetHeight)
-{ 
-    // TODO : const float OneSectorHeight = RenderTargetHeight * cam.nearPlaneDistance;
-    
-    const Sector& currentSector = world.Sectors.at(cam.currentSectorId);
-    return Lerp((float)RenderTargetHeight, 0.f, currentSector.zFloor);
+    VisibleWallsDepthOrder depthOrder {
+        .order = ctx.frameArena.Allocate<uint32_t>(visibleWallsCount),
+        .nearestDistances = ctx.frameArena.Allocate<float>(visibleWallsCount),
+    };
+
+    for(uint32_t i = 0; i < visibleWallsCount; ++i)
+    {
+        const Segment segment = ctx.world->WallSegment(visibleWalls.wallIndices[i]);
+
+        depthOrder.order[i] = i;
+        depthOrder.nearestDistances[i] = PointSegmentDistance(ctx.cam->position, segment.a, segment.b);
+    }
+
+    std::sort(depthOrder.order.begin(), depthOrder.order.end(), [&depthOrder](uint32_t a, uint32_t b)
+    {
+        return depthOrder.nearestDistances[a] < depthOrder.nearestDistances[b];
+    });
+
+    return depthOrder;
 }
 
-CameraYLineData ComputeCameraYAxis(
-    const RaycastingCamera& cam, uint32_t renderTargetX, float hitDistance, 
-    float FloorVerticalOffset, float CamCurrentSectorElevationOffset,
-    uint32_t RenderTargetWidth, uint32_t RenderTargetHeight,
-    uint32_t YHigh, uint32_t YLow,
-    float topOffsetPercentage, float bottomOffsetPercentage
-)
+RaycastHitData FindNearestWallHitCoherent(RasterizeWorldContext& ctx, const VisibleWalls& visibleWalls, 
+    const VisibleWallsDepthOrder& depthOrder, const RasterRay& ray, uint32_t& coherentWall)
 {
-    const float depth = Clamp(hitDistance, 0, cam.farPlaneDistance);
-    // Normalize distance to [0, 1]
-    const float normalizedDepth = depth / cam.farPlaneDistance;
+    const RenderWorld& world = *ctx.world;
 
-    const float rayDirectionDeg = cam.fov * (floor(0.5 * RenderTargetWidth) - renderTargetX) / RenderTargetWidth;
-    const float rayProjectionPositionInScreen = 0.5 * tanf(rayDirectionDeg * DEG2RAD) / tanf((0.5 * cam.fov) * DEG2RAD);
-    const float objectHeight = round(RenderTargetHeight * cam.nearPlaneDistance / (depth * cosf(rayDirectionDeg * DEG2RAD)));
+    ++ctx.tracedColumnsCount;
 
-    // Rendering
-    const float heightDelta = RenderTargetHeight - objectHeight;
-    const float halfHeightDelta = heightDelta / 2;
-    
-    const float fullSizeTopY = (halfHeightDelta - FloorVerticalOffset);
-    
-    float topY    = fullSizeTopY + (objectHeight * topOffsetPercentage);
-    float bottomY = (fullSizeTopY + objectHeight) - (objectHeight * bottomOffsetPercentage);
+    HitInfo hitInfo;
+
+    uint32_t bestWall = NULL_VISIBLE_WALL;
+    HitInfo bestHitInfo { .distance = std::numeric_limits<float>::max() };
+
+    // Previous column wall missed, scan every visible wall
+    if(coherentWall == NULL_VISIBLE_WALL 
+        || !RayToSegmentCollision(ray, world.WallSegment(visibleWalls.wallIndices[coherentWall]), hitInfo))
+    {
+        for(uint32_t wall = 0; wall < visibleWalls.wallIndices.size(); ++wall)
+        {
+            if(RayToSegmentCollision(ray, world.WallSegment(visibleWalls.wallIndices[wall]), hitInfo) 
+                && bestHitInfo.distance > hitInfo.distance)
+            {
+                bestWall = wall;
+                bestHitInfo = hitInfo;
+            }
+        }
+
+        coherentWall = bestWall;
+
+        if(bestWall == NULL_VISIBLE_WALL) return {};
+
+        return {
+            .distance = bestHitInfo.distance,
+            .position = bestHitInfo.position,
+            .wallIndex = visibleWalls.wallIndices[bestWall],
+        };
+    }
+
+    ++ctx.coherentColumnsCount;
+
+    bestWall = coherentWall;
+    bestHitInfo = hitInfo;
+
+    for(uint32_t wall : depthOrder.order)
+    {
+        // The hit distance is rounded differently than the nearest distance, the margins keep the early out safe
+        if(depthOrder.nearestDistances[wall] > bestHitInfo.distance * RasterDistanceRelativeMargin + RasterDistanceTolerance) break;
+
+        if(wall == coherentWall) continue;
+
+        if(!RayToSegmentCollision(ray, world.WallSegment(visibleWalls.wallIndices[wall]), hitInfo)) continue;
+
+        // On equal distances the full scan keeps the first wall in sector order
+        if(hitInfo.distance < bestHitInfo.distance || (hitInfo.distance == bestHitInfo.distance && wall < bestWall))
+        {
+            bestWall = wall;
+            bestHitInfo = hitInfo;
+        }
+    }
 
-    topY += CamCurrentSectorElevationOffset;
-    bottomY += CamCurrentSectorElevationOffset;
+    coherentWall = bestWall;
 
     return {
-        .top    = { static_cast<float>(renderTargetX), Clamp(topY, YLow, YHigh) }, 
-        .bottom = { static_cast<float>(renderTargetX), Clamp(bottomY, YLow, YHigh) },
-        .depth  = depth,
-        .normalizedDepth = normalizedDepth
+        .distance = bestHitInfo.distance,
+        .position = bestHitInfo.position,
+        .wallIndex = visibleWalls.wallIndices[bestWall],
     };
 }
 
-void RenderCameraYLine(CameraYLineData renderData, Color color, bool topEdge, bool bottomEdge)
+RaycastHitData FindNearestWallHitBvh(const RasterizeWorldContext& ctx, SectorIndex sectorIndex, const RasterRay& ray)
 {
-    float darkness = Lerp(1, 0, renderData.normalizedDepth);
+    HitInfo hitInfo;
+    const WallIndex wallIndex = RayToSectorWallBvhNearestHit(*ctx.world, sectorIndex, ctx.camSectorIndex, ray, hitInfo);
 
-    DrawLineV(
-        renderData.top, 
-        renderData.bottom, 
-        ColorDarken(color, renderData.normalizedDepth)
-    );
+    if(wallIndex == NULL_WALL_INDEX) return {};
 
-    if(topEdge)
-        DrawRectangle(renderData.top.x - 1, renderData.top.y - 1, 3, 3, GRAY);
-    if(bottomEdge)
-        DrawRectangle(renderData.bottom.x - 1, renderData.bottom.y - 1, 3, 3, GRAY);
+    return {
+        .distance = hitInfo.distance,
+        .position = hitInfo.position,
+        .wallIndex = wallIndex,
+    };
 }
 
+RaycastHitData FindNearestWallHitSimd(const VisibleWalls& visibleWalls, const RasterRay& ray)
+{
+    HitInfo hitInfo;
+    const int32_t wallIndex = RayToWallsNearestHit(ray, visibleWalls.walls, hitInfo);
+
+    if(wallIndex < 0) return {};
 
-WorldRasterizer::WorldRasterizer(uint32_t renderTargetWidth, uint32_t renderTargetHeight, const World& world, const RaycastingCamera& cam)
+    return {
+        .distance = hitInfo.distance,
+        .position = hitInfo.position,
+        .wallIndex = visibleWalls.wallIndices[wallIndex],
+    };
+}
+
+void ProjectWallSpansInRenderArea(const RasterizeWorldContext& ctx, const VisibleWalls& visibleWalls, RenderArea renderArea, std::span<RaycastHitData> columnHits)
 {
-    Reset(renderTargetWidth, renderTargetHeight, world, cam);
+    const RenderWorld& world = *ctx.world;
+
+    // "columnHits must hold one entry per column of the render area"
+    assert(columnHits.size() == renderArea.xEnd - renderArea.xBegin + 1);
+
+    // Walls were projected and clipped to the render area by CullSectorWalls
+    for(size_t i = 0; i < visibleWalls.wallIndices.size(); ++i)
+    {
+        const WallIndex wallIndex = visibleWalls.wallIndices[i];
+        const Segment segment = world.WallSegment(wallIndex);
+        const WallColumnSpans& columnSpans = visibleWalls.columnSpans[i];
+
+        for(uint32_t spanIndex = 0; spanIndex < columnSpans.spansCount; ++spanIndex)
+        {
+            const RenderArea& span = columnSpans.spans[spanIndex];
+
+            for(uint32_t x = span.xBegin; x <= span.xEnd; ++x)
+            {
+                HitInfo hitInfo;
+                if(!RayToSegmentCollision(ComputeColumnRay(ctx, x), segment, hitInfo))
+                    continue;
+
+                RaycastHitData& columnHit = columnHits[x - renderArea.xBegin];
+
+                // Walls are visited in the same order as the Ray mode so ties resolve the same way
+                if(columnHit.distance > hitInfo.distance)
+                {
+                    columnHit = {
+                        .distance = hitInfo.distance,
+                        .position = hitInfo.position,
+                        .wallIndex = wallIndex,
+                    };
+                }
+            }
+        }
+    }
 }
 
-void WorldRasterizer::Reset(uint32_t renderTargetWidth, uint32_t renderTargetHeight, const World &world, const RaycastingCamera &cam)
+uint32_t ProjectSegmentToScreenColumns(const RaycastingCamera& cam, uint32_t renderTargetWidth, const Segment& segment, RenderArea outSpans[2])
 {
-    ctx.world = &world;
-    ctx.cam = &cam;
-    ctx.FloorVerticalOffset = ComputeVerticalOffset(cam, renderTargetHeight);
-    ctx.CamCurrentSectorElevationOffset = 0; // TODO : ComputeElevationOffset(cam, world, RenderTargetHeight);
-    ctx.RenderTargetWidth = renderTargetWidth;
-    ctx.RenderTargetHeight = renderTargetHeight;
-    ctx.currentRenderItr = 0;
+    if(renderTargetWidth == 0 || cam.fov <= 0) return 0;
 
-    ctx.yBoundaries.resize(renderTargetWidth);
+    const int64_t lastColumn = renderTargetWidth - 1;
 
-    std::fill(ctx.yBoundaries.begin(), ctx.yBoundaries.end(), MinMax<uint32_t> {
-        .max = renderTargetHeight,
-        .min = 0,
-    });
+    const auto wrapAngleDeg = [](float angle)
+    {
+        angle = fmodf(angle + 180.f, 360.f);
+        if(angle < 0) angle += 360.f;
+        return angle - 180.f;
+    };
 
-    // "Try to InitRasterizeWorldContext with an invalid SectorID"
-    assert(world.Sectors.contains(ctx.cam->currentSectorId));
+    const Vector2 toA = Vector2Subtract(segment.a, cam.position);
+    const Vector2 toB = Vector2Subtract(segment.b, cam.position);
+
+    const float angleA = wrapAngleDeg((Vector2DirectionToAngle(toA) - cam.yaw) * RAD2DEG);
+    const float angleB = wrapAngleDeg((Vector2DirectionToAngle(toB) - cam.yaw) * RAD2DEG);
+    const float delta = wrapAngleDeg(angleB - angleA);
 
-    // Clear the render stack
-    if(ctx.renderStack.size() > 0)
+    // Camera stands on the segment line (or on an endpoint), every column may see it
+    constexpr float DegenerateEpsilon = 1e-3f;
+    if(fabsf(delta) >= 180.f - DegenerateEpsilon
+        || Vector2LengthSqr(toA) < DegenerateEpsilon 
+        || Vector2LengthSqr(toB) < DegenerateEpsilon)
     {
-        std::stack<SectorRenderContext>().swap(ctx.renderStack);    
+        outSpans[0] = { .xBegin = 0, .xEnd = static_cast<uint32_t>(lastColumn) };
+        return 1;
     }
 
-    ctx.renderStack.push({
-        .sectorId = ctx.cam->currentSectorId,
-        .renderArea = {
-            .xBegin = 0,
-            .xEnd = renderTargetWidth > 0 ? (renderTargetWidth - 1) : 0,
-        }
-    });
+    const float angleLow = (delta < 0) ? angleA + delta : angleA;
+    const float angleHigh = angleLow + fabsf(delta);
+
+    // Inverse of RayAngleForScreenXCam
+    const float columnsPerDeg = static_cast<float>(renderTargetWidth) / cam.fov;
+    const float halfFov = cam.fov / 2;
+
+    uint32_t spansCount = 0;
+
+    // Column angles live in [-180, 180], so the wall interval may have to be unwrapped once
+    for(float shift : { 0.f, -360.f, 360.f })
+    {
+        // One column of padding on each side absorbs the float error between this projection and the column rays
+        const int64_t xBegin = static_cast<int64_t>(floorf((angleLow + shift + halfFov) * columnsPerDeg)) - 1;
+        const int64_t xEnd = static_cast<int64_t>(ceilf((angleHigh + shift + halfFov) * columnsPerDeg)) + 1;
+
+        if(xEnd < 0 || xBegin > lastColumn) continue;
+
+        outSpans[spansCount++] = {
+            .xBegin = static_cast<uint32_t>(std::max<int64_t>(xBegin, 0)),
+            .xEnd = static_cast<uint32_t>(std::min<int64_t>(xEnd, lastColumn)),
+        };
+
+        if(spansCount == 2) break;
+    }
+
+    return spansCount;
 }
 
-void WorldRasterizer::RasterizeWorldInTexture(const RenderTexture& renderTexture)
+void RasterizeColumnHit(RasterizeWorldContext& ctx, SectorIndex currentSectorIndex, uint32_t x, const RaycastHitData& bestHitData, NextRenderAreas& renderAreaToPushInStack)
 {
-    assert(ctx.RenderTargetWidth == renderTexture.texture.width && ctx.RenderTargetHeight == renderTexture.texture.height);
+    if(bestHitData.wallIndex == NULL_WALL_INDEX)
+    {
+        CloseColumn(ctx, x);
+        return;
+    }
 
-    BeginTextureMode(renderTexture);
-        RasterizeWorld();
-    EndTextureMode();
+    const SectorIndex nextSectorIndex = ctx.world->wallToSector[bestHitData.wallIndex];
+
+    DrawColumnHit(ctx, currentSectorIndex, nextSectorIndex, x, bestHitData);
+
+    // Solid wall, or the portal borders left no room to see through
+    if(nextSectorIndex == NULL_SECTOR_INDEX || ctx.yBoundaries[x].min >= ctx.yBoundaries[x].max)
+    {
+        CloseColumn(ctx, x);
+        return;
+    }
+
+    // Everything seen through the portal is past the far plane, nothing but fog to draw
+    if(bestHitData.distance > ctx.cam->farPlaneDistance)
+    {
+        FillColumnWithFog(ctx, x);
+        return;
+    }
+
+    ctx.columnSectors[x] = nextSectorIndex;
+    ExtendNextRenderArea(renderAreaToPushInStack, nextSectorIndex, x, x, bestHitData.distance);
 }
 
-void WorldRasterizer::RasterizeWorld()
+void DrawColumnHit(RasterizeWorldContext& ctx, SectorIndex currentSectorIndex, SectorIndex nextSectorIndex, uint32_t x, const RaycastHitData& bestHitData)
 {
-    ClearBackground(MY_BLACK);
+    MinMaxUint32& yMinMax = ctx.yBoundaries[x];
 
-    while(IsRenderIterationRemains()) 
+    // What the wall does not cover is left to the floor and ceiling
+    const MinMaxUint32 window = yMinMax;
+    MinMaxUint32 coveredRows;
+
+    // Means this is a slid wall
+    if(nextSectorIndex == NULL_SECTOR_INDEX)
     {
-        RenderIteration();
+        const RenderSector& currentSector = ctx.world->sectors[currentSectorIndex];
+        const ColumnHitProjection hitProjection = ProjectColumnHit(ctx, x, bestHitData.distance);
+
+        CameraYLineData cameraWallYData = 
+            ComputeCameraYAxis(ctx, hitProjection,
+                yMinMax.max,
+                yMinMax.min,
+                currentSector.zFloor, currentSector.zCeiling
+            );
+
+        if(const WallTextureView* wallTexture = FindWallTexture(ctx, bestHitData.wallIndex))
+        {
+            const float wallU = Vector2Distance(ctx.world->WallSegment(bestHitData.wallIndex).a, bestHitData.position) / WallTextureWorldWidth;
+            RenderTexturedWallColumn(ctx, cameraWallYData, hitProjection, *wallTexture, wallU);
+        }
+        else
+        {
+            RenderCameraYLine(ctx, cameraWallYData, ctx.world->wallColors[bestHitData.wallIndex], ctx.paletteIndices->walls[bestHitData.wallIndex]);
+        }
+
+        coveredRows = {
+            .max = static_cast<uint32_t>(floorf(std::max(cameraWallYData.top.y, cameraWallYData.bottom.y))),
+            .min = static_cast<uint32_t>(floorf(std::min(cameraWallYData.top.y, cameraWallYData.bottom.y))),
+        };
     }
+    else
+    {
+        RenderNextAreaBorders(ctx, yMinMax, currentSectorIndex, nextSectorIndex, x, bestHitData.distance, coveredRows);
+    
+        // Draw a Purple placeholder where next sector will be drawn
+        DrawColumnSpan(ctx, {(float)x, (float)yMinMax.min}, { (float)x, (float)yMinMax.max }, PURPLE);
+    }
+
+    SetColumnPlaneSpans(ctx, x, window, coveredRows);
 }
 
-bool WorldRasterizer::IsRenderIterationRemains() const
+void SetColumnPlaneSpans(RasterizeWorldContext& ctx, uint32_t x, MinMaxUint32 window, MinMaxUint32 coveredRows)
 {
-    return (!ctx.renderStack.empty() && ctx.currentRenderItr < ctx.cam->maxRenderItr);
+    ctx.ceilingSpans[x - ctx.planeSpansXBegin] = { .max = coveredRows.min, .min = window.min };
+    ctx.floorSpans[x - ctx.planeSpansXBegin] = { .max = window.max, .min = coveredRows.max };
 }
 
-void WorldRasterizer::RenderIteration()
+void DrawSectorPlanes(RasterizeWorldContext& ctx, SectorIndex sectorIndex, RenderArea renderArea)
 {
-    // "Rendering is ended, RenderIteration should not be called"
-    assert(IsRenderIterationRemains());
+    const RenderSector& sector = ctx.world->sectors[sectorIndex];
+    const RenderSectorColors& colors = ctx.world->sectorColors[sectorIndex];
+    const RenderSectorPaletteIndices& colorIndices = ctx.paletteIndices->sectors[sectorIndex];
 
-    RasterizeInRenderArea(ctx, ctx.renderStack.top());
+    DrawPlaneSpans(ctx, ctx.ceilingSpans, renderArea, colors.ceiling, colorIndices.ceiling, false, sector.zCeiling);
+    DrawPlaneSpans(ctx, ctx.floorSpans, renderArea, colors.floor, colorIndices.floor, true, sector.zFloor);
+}
 
-    ctx.currentRenderItr++;
-}
\ No newline at end of file
+void DrawPlaneSpans(RasterizeWorldContext& ctx, std::span<const MinMaxUint32> columnSpans, RenderArea renderArea, Color color, PaletteIndex colorIndex,
+    bool isFloor, float planeZ)
+{
+    uint32_t* spanStarts = ctx.planeSpanStarts.data();
+
+    const auto drawRow = [&ctx, color, colorIndex, isFloor, planeZ, spanStarts](uint32_t y, uint32_t xEnd)
+    {
+        DrawShadedRowSpan(ctx, y, spanStarts[y], xEnd, color, colorIndex, PlaneRowNormalizedDepth(ctx, y, isFloor, planeZ));
+    };
+
+    // Rows [top, bottom[ of the previous column, like Doom R_MakeSpans rows ending before the
+    // current column are drawn and rows starting at it are opened, unchanged rows cost nothing
+    uint32_t previousTop = 0;
+    uint32_t previousBottom = 0;
+
+    for(uint32_t x = renderArea.xBegin; x <= renderArea.xEnd + 1; ++x)
+    {
+        uint32_t top = 0;
+        uint32_t bottom = 0;
+
+        if(x <= renderArea.xEnd && columnSpans[x - renderArea.xBegin].min < columnSpans[x - renderArea.xBegin].max)
+        {
+            top = columnSpans[x - renderArea.xBegin].min;
+            bottom = columnSpans[x - renderArea.xBegin].max;
+        }
+
+        while(previousTop < top && previousTop < previousBottom) drawRow(previousTop++, x - 1);
+        while(previousBottom > bottom && previousBottom > previousTop) drawRow(--previousBottom, x - 1);
+
+        uint32_t openedTop = top;
+        uint32_t openedBottom = bottom;
+
+        while(openedTop < previousTop && openedTop < bottom) spanStarts[openedTop++] = x;
+        while(openedBottom > previousBottom && openedBottom > openedTop) spanStarts[--openedBottom] = x;
+
+        previousTop = top;
+        previousBottom = bottom;
+    }
+}
+
+float PlaneRowNormalizedDepth(const RasterizeWorldContext& ctx, uint32_t y, bool isFloor, float planeZ)
+{
+    // Inverse of ComputeCameraYAxis: the floor row of a wall is planeZ of its height below the wall top,
+    // the ceiling row 1 - planeZ, so both are (planeZ - 0.5) wall heights away from the horizon row
+    const float rowCenter = y + 0.5f + ctx.FloorVerticalOffset - ctx.CamCurrentSectorElevationOffset;
+    const float twiceHorizonDistance = isFloor ? (2 * rowCenter - ctx.RenderTargetHeight) : (ctx.RenderTargetHeight - 2 * rowCenter);
+    const float twicePlaneOffset = 2 * planeZ - 1;
+
+    // A plane on the other side of the eye is never seen on this side of the horizon
+    if(twiceHorizonDistance <= 0 || twicePlaneOffset <= 0) return 1;
+
+    const float objectHeight = twiceHorizonDistance / twicePlaneOffset;
+
+    const float depth = ctx.RenderTargetHeight * ctx.cam->nearPlaneDistance / objectHeight;
+    return Clamp(depth / ctx.cam->farPlaneDistance, 0, 1);
+}
+
+void ExtendNextRenderArea(NextRenderAreas& renderAreaToPushInStack, SectorIndex nextSectorIndex, uint32_t xBegin, uint32_t xEnd, float portalDistance)
+{
+    // Create / update NextRenderArea
+
+    uint32_t& areaSlot = renderAreaToPushInStack.areaSlots[nextSectorIndex];
+
+    // Areas only grow when the new columns directly follow the last area of the sector
+    const bool startNewArea = (areaSlot == NULL_AREA_SLOT) 
+        || (renderAreaToPushInStack.areas[areaSlot].renderArea.xEnd + 1 != xBegin);
+
+    if(startNewArea)
+    {
+        // "More next render areas than columns in the render area"
+        assert(renderAreaToPushInStack.areasCount < renderAreaToPushInStack.areas.size());
+
+        areaSlot = renderAreaToPushInStack.areasCount++;
+
+        renderAreaToPushInStack.areas[areaSlot] = {
+            .sectorIndex = nextSectorIndex,
+            .renderArea = {
+                .xBegin = xBegin,
+                .xEnd = xEnd
+            },
+            .nearestDistance = portalDistance,
+        };
+    }
+    else
+    {
+        SectorRenderContext& area = renderAreaToPushInStack.areas[areaSlot];
+        area.renderArea.xEnd = std::max(area.renderArea.xEnd, xEnd);
+        area.nearestDistance = std::min(area.nearestDistance, portalDistance);
+    }
+}
+
+void RasterizeRayPacket(RasterizeWorldContext& ctx, SectorIndex currentSectorIndex, const VisibleWalls& visibleWalls, uint32_t xBegin, uint32_t lanesCount, NextRenderAreas& renderAreaToPushInStack)
+{
+    const RenderWorld& world = *ctx.world;
+
+    // Lanes whose column is not waiting for this sector are traced but never drawn
+    uint32_t activeLanes = 0;
+    for(uint32_t lane = 0; lane < lanesCount; ++lane)
+    {
+        if(ctx.columnSectors[xBegin + lane] == currentSectorIndex)
+            activeLanes |= (1U << lane);
+    }
+
+    if(activeLanes == 0) return;
+
+    RayPacket packet;
+    packet.position = ctx.cam->position;
+    packet.lanesCount = lanesCount;
+
+    for(uint32_t lane = 0; lane < lanesCount; ++lane)
+    {
+        const RasterRay laneRay = ComputeColumnRay(ctx, xBegin + lane);
+        packet.directionX[lane] = laneRay.direction.x;
+        packet.directionY[lane] = laneRay.direction.y;
+    }
+
+    RayPacketHits hits;
+    RayPacketToWallsNearestHits(packet, visibleWalls.walls, hits);
+    const int32_t* wallIndices = hits.wallIndices;
+
+    // Split the packet into sub-masks of lanes that hit the same wall,
+    // the wall and its next sector are then resolved once per sub-mask instead of once per column
+    struct SubPacket
+    {
+        uint32_t lanesMask = 0;
+        WallIndex wallIndex = NULL_WALL_INDEX;
+        SectorIndex nextSectorIndex = NULL_SECTOR_INDEX;
+    };
+
+    SubPacket subPackets[RayPacketSize];
+    uint32_t laneSubPacket[RayPacketSize];
+    uint32_t subPacketsCount = 0;
+
+    uint32_t pendingLanes = activeLanes;
+
+    while(pendingLanes != 0)
+    {
+        const uint32_t firstLane = std::countr_zero(pendingLanes);
+        const int32_t wallIndex = wallIndices[firstLane];
+
+        SubPacket& subPacket = subPackets[subPacketsCount];
+
+        for(uint32_t lane = firstLane; lane < lanesCount; ++lane)
+        {
+            if((pendingLanes & (1U << lane)) && wallIndices[lane] == wallIndex)
+            {
+                subPacket.lanesMask |= (1U << lane);
+                laneSubPacket[lane] = subPacketsCount;
+            }
+        }
+
+        pendingLanes &= ~subPacket.lanesMask;
+
+        if(wallIndex >= 0)
+        {
+            subPacket.wallIndex = visibleWalls.wallIndices[wallIndex];
+            subPacket.nextSectorIndex = world.wallToSector[subPacket.wallIndex];
+        }
+
+        ++subPacketsCount;
+    }
+
+    // Lanes whose column got closed, they don't lead to the next sector
+    uint32_t closedLanes = 0;
+    float laneDistances[RayPacketSize];
+
+    // Columns are drawn left to right so overlapping edge markers end up like in the other modes
+    for(uint32_t lane = 0; lane < lanesCount; ++lane)
+    {
+        if(!(activeLanes & (1U << lane))) continue;
+
+        const SubPacket& subPacket = subPackets[laneSubPacket[lane]];
+        const uint32_t x = xBegin + lane;
+
+        if(subPacket.wallIndex == NULL_WALL_INDEX)
+        {
+            CloseColumn(ctx, x);
+            closedLanes |= (1U << lane);
+            continue;
+        }
+
+        // The kernel kept the hit of the lane winner, it is the one RayToSegmentCollision gives
+        const float hitDistance = hits.distances[lane];
+        laneDistances[lane] = hitDistance;
+
+        DrawColumnHit(ctx, currentSectorIndex, subPacket.nextSectorIndex, x, {
+            .distance = hitDistance,
+            .position = { hits.positionsX[lane], hits.positionsY[lane] },
+            .wallIndex = subPacket.wallIndex,
+        });
+
+        if(subPacket.nextSectorIndex == NULL_SECTOR_INDEX || ctx.yBoundaries[x].min >= ctx.yBoundaries[x].max)
+        {
+            CloseColumn(ctx, x);
+            closedLanes |= (1U << lane);
+            continue;
+        }
+
+        if(hitDistance > ctx.cam->farPlaneDistance)
+        {
+            FillColumnWithFog(ctx, x);
+            closedLanes |= (1U << lane);
+            continue;
+        }
+
+        ctx.columnSectors[x] = subPacket.nextSectorIndex;
+    }
+
+    for(uint32_t i = 0; i < subPacketsCount; ++i)
+    {
+        const SubPacket& subPacket = subPackets[i];
+        if(subPacket.nextSectorIndex == NULL_SECTOR_INDEX) continue;
+
+        // One call per run of adjacent lanes, lanes in between may belong to another portal
+        uint32_t lanesMask = subPacket.lanesMask & ~closedLanes;
+
+        while(lanesMask != 0)
+        {
+            const uint32_t firstLane = std::countr_zero(lanesMask);
+            const uint32_t runLength = std::countr_one(lanesMask >> firstLane);
+
+            const float runDistance = *std::min_element(laneDistances + firstLane, laneDistances + firstLane + runLength);
+
+            ExtendNextRenderArea(renderAreaToPushInStack, subPacket.nextSectorIndex, xBegin + firstLane, xBegin + firstLane + runLength - 1, runDistance);
+
+            lanesMask &= ~(((1U << runLength) - 1) << firstLane);
+        }
+    }
+}
+
+void FillColumnWithFog(RasterizeWorldContext& ctx, uint32_t x)
+{
+    // Covers the placeholder the portal hit left in the opening
+    DrawColumnSpan(ctx, { (float)x, (float)ctx.yBoundaries[x].min }, { (float)x, (float)ctx.yBoundaries[x].max }, FarPlaneFogColor);
+    CloseColumn(ctx, x);
+}
+
+void CloseColumn(RasterizeWorldContext& ctx, uint32_t x)
+{
+    ctx.columnSectors[x] = NULL_SECTOR_INDEX;
+    ++ctx.closedColumnsCount;
+
+    // Parallel contexts own disjoint columns but two of them may share a word
+    std::atomic_ref<uint64_t> word(ctx.closedColumns[x / 64]);
+    word.fetch_or(uint64_t(1) << (x % 64), std::memory_order_relaxed);
+}
+
+bool IsColumnClosed(const RasterizeWorldContext& ctx, uint32_t x)
+{
+    return (std::atomic_ref<uint64_t>(ctx.closedColumns[x / 64]).load(std::memory_order_relaxed) >> (x % 64)) & 1;
+}
+
+uint32_t NextOpenColumn(const RasterizeWorldContext& ctx, uint32_t x, uint32_t xEnd)
+{
+    while(x <= xEnd)
+    {
+        // Open columns of the word from x on
+        const uint64_t openBits = ~std::atomic_ref<uint64_t>(ctx.closedColumns[x / 64]).load(std::memory_order_relaxed) >> (x % 64);
+
+        if(openBits != 0)
+        {
+            return std::min(x + static_cast<uint32_t>(std::countr_zero(openBits)), xEnd + 1);
+        }
+
+        x = (x / 64 + 1) * 64;
+    }
+
+    return xEnd + 1;
+}
+
+bool TrimRenderAreaToOpenColumns(const RasterizeWorldContext& ctx, RenderArea& renderArea)
+{
+    const uint32_t xBegin = NextOpenColumn(ctx, renderArea.xBegin, renderArea.xEnd);
+    if(xBegin > renderArea.xEnd) return false;
+
+    uint32_t xEnd = renderArea.xEnd;
+    while(IsColumnClosed(ctx, xEnd)) --xEnd;
+
+    renderArea = { .xBegin = xBegin, .xEnd = xEnd };
+    return true;
+}
+
+void RenderNextAreaBorders(RasterizeWorldContext& worldContext, MinMaxUint32& yMinMax, SectorIndex currentSectorIndex, SectorIndex nextSectorIndex, uint32_t x, float hitDistance,
+    MinMaxUint32& coveredRows)
+{
+    // TODO : 
+    // zCeilling shloud not be < to current zFloor
+    // And this is the same in the other way
+    // zFloor should not be > to current zCeiling
+
+    const RenderSector& currentSector = worldContext.world->sectors[currentSectorIndex];
+    const RenderSector& nextSector = worldContext.world->sectors[nextSectorIndex];
+    const RenderSectorColors& nextSectorColors = worldContext.world->sectorColors[nextSectorIndex];
+    const RenderSectorPaletteIndices& nextSectorColorIndices = worldContext.paletteIndices->sectors[nextSectorIndex];
+
+    // Both borders are cut in the same wall projection
+    const ColumnHitProjection hitProjection = ProjectColumnHit(worldContext, x, hitDistance);
+ 
+    // Top Border
+    {
+        bool nextSectCelingHigher = nextSector.zCeiling >= currentSector.zCeiling;
+
+        const RenderSector& zSizesSector = (nextSectCelingHigher) ? currentSector : nextSector;
+
+        CameraYLineData topBorderLineData = ComputeCameraYAxis(worldContext, hitProjection,
+            yMinMax.max, yMinMax.min,
+            0, zSizesSector.zCeiling
+        );
+
+        if(!nextSectCelingHigher)
+        {
+            bool topEdge = !nextSectCelingHigher;
+            RenderCameraYLine(worldContext, topBorderLineData, nextSectorColors.topBorder, nextSectorColorIndices.topBorder, topEdge, true);
+        }
+
+        // Apply Y min
+        yMinMax.min = topBorderLineData.bottom.y;
+        coveredRows.min = !nextSectCelingHigher ? static_cast<uint32_t>(floorf(topBorderLineData.top.y)) : yMinMax.min;
+    }
+
+    // Bottom Border
+    {
+        bool nextSectFloorHigher = nextSector.zFloor >= currentSector.zFloor;
+
+        const RenderSector& zSizesSector = (nextSectFloorHigher) ? currentSector : nextSector;
+
+        CameraYLineData bottomBorderLineData = ComputeCameraYAxis(worldContext, hitProjection,
+            yMinMax.max, yMinMax.min,
+            zSizesSector.zFloor, 0
+        );
+
+        if(!nextSectFloorHigher)
+        {
+            bool bottomEdge = !nextSectFloorHigher;
+            RenderCameraYLine(worldContext, bottomBorderLineData, nextSectorColors.bottomBorder, nextSectorColorIndices.bottomBorder, true, bottomEdge);
+        }
+
+        // Apply Y max
+        yMinMax.max = bottomBorderLineData.top.y;
+        coveredRows.max = !nextSectFloorHigher ? static_cast<uint32_t>(floorf(bottomBorderLineData.bottom.y)) : yMinMax.max;
+    }
+}
+
+template<typename Scalar>
+float ComputeVerticalOffsetAs(const RaycastingCamera& cam, uint32_t RenderTargetHeight)
+{
+    const Scalar half = ToRasterScalar<Scalar>(0.5f);
+
+    return RasterScalarToFloat(RasterRound(half * RasterScalarFromInt<Scalar>(RenderTargetHeight) * RasterTan(ToRasterScalar<Scalar>(cam.pitch))
+        / RasterTan(half * ToRasterScalar<Scalar>(cam.fovVectical))));
+}
+
+template float ComputeVerticalOffsetAs<float>(const RaycastingCamera& cam, uint32_t RenderTargetHeight);
+template float ComputeVerticalOffsetAs<Fixed16>(const RaycastingCamera& cam, uint32_t RenderTargetHeight);
+
+float ComputeVerticalOffset(const RaycastingCamera& cam, uint32_t RenderTargetHeight)
+{
+    return ComputeVerticalOffsetAs<RasterScalar>(cam, RenderTargetHeight);
+}
+
+float ComputeElevationOffset(const RaycastingCamera& cam, const World& world, uint32_t RenderTargetHeight)
+{ 
+    // TODO : const float OneSectorHeight = RenderTargetHeight * cam.nearPlaneDistance;
+    
+    const Sector& currentSector = world.Sectors.at(cam.currentSectorId);
+
+    // Lerp(RenderTargetHeight, 0, zFloor)
+    const RasterScalar height = RasterScalarFromInt<RasterScalar>(RenderTargetHeight);
+    return RasterScalarToFloat(height + ToRasterScalar<RasterScalar>(currentSector.zFloor) * (RasterScalar {} - height));
+}
+
+template<typename Scalar>
+ColumnHitProjection ProjectColumnHitAs(const RaycastingCamera& cam, uint32_t renderTargetX, float hitDistance, float rayCosine, uint32_t RenderTargetHeight)
+{
+    const Scalar farPlaneDistance = ToRasterScalar<Scalar>(cam.farPlaneDistance);
+    const Scalar depth = RasterClamp(ToRasterScalar<Scalar>(hitDistance), Scalar {}, farPlaneDistance);
+
+    return {
+        .renderTargetX = renderTargetX,
+        .depth = RasterScalarToFloat(depth),
+        // Normalize distance to [0, 1]
+        .normalizedDepth = RasterScalarToFloat(depth / farPlaneDistance),
+        .objectHeight = RasterScalarToFloat(RasterRound(WideQuotient(
+            WideProduct(RasterScalarFromInt<Scalar>(RenderTargetHeight), ToRasterScalar<Scalar>(cam.nearPlaneDistance)),
+            WideProduct(depth, ToRasterScalar<Scalar>(rayCosine))))),
+    };
+}
+
+template ColumnHitProjection ProjectColumnHitAs<float>(const RaycastingCamera& cam, uint32_t renderTargetX, float hitDistance, float rayCosine, uint32_t RenderTargetHeight);
+template ColumnHitProjection ProjectColumnHitAs<Fixed16>(const RaycastingCamera& cam, uint32_t renderTargetX, float hitDistance, float rayCosine, uint32_t RenderTargetHeight);
+
+ColumnHitProjection ProjectColumnHit(const RaycastingCamera& cam, uint32_t renderTargetX, float hitDistance, float rayCosine, uint32_t RenderTargetHeight)
+{
+    return ProjectColumnHitAs<RasterScalar>(cam, renderTargetX, hitDistance, rayCosine, RenderTargetHeight);
+}
+
+ColumnHitProjection ProjectColumnHit(const RasterizeWorldContext& ctx, uint32_t renderTargetX, float hitDistance)
+{
+    return ProjectColumnHit(*ctx.cam, renderTargetX, hitDistance, ctx.projection->rayCosines[renderTargetX], ctx.RenderTargetHeight);
+}
+
+CameraYLineData ComputeCameraYAxis(
+    const RaycastingCamera& cam, uint32_t renderTargetX, float hitDistance, 
+    float FloorVerticalOffset, float CamCurrentSectorElevationOffset,
+    uint32_t RenderTargetWidth, uint32_t RenderTargetHeight,
+    uint32_t YHigh, uint32_t YLow,
+    float topOffsetPercentage, float bottomOffsetPercentage
+)
+{
+    // Same term as ProjectionCache::rayCosines
+    const float rayCosine = ComputeColumnRayCosine(cam, renderTargetX, RenderTargetWidth);
+
+    return ComputeCameraYAxis(
+        ProjectColumnHit(cam, renderTargetX, hitDistance, rayCosine, RenderTargetHeight),
+        FloorVerticalOffset, CamCurrentSectorElevationOffset, RenderTargetHeight,
+        YHigh, YLow, topOffsetPercentage, bottomOffsetPercentage
+    );
+}
+
+CameraYLineData ComputeCameraYAxis(
+    const RasterizeWorldContext& ctx, const ColumnHitProjection& hitProjection,
+    uint32_t YHigh, uint32_t YLow,
+    float topOffsetPercentage, float bottomOffsetPercentage
+)
+{
+    return ComputeCameraYAxis(hitProjection, 
+        ctx.FloorVerticalOffset, ctx.CamCurrentSectorElevationOffset, ctx.RenderTargetHeight,
+        YHigh, YLow, topOffsetPercentage, bottomOffsetPercentage
+    );
+}
+
+template<typename Scalar>
+CameraYLineData ComputeCameraYAxisAs(
+    const ColumnHitProjection& hitProjection,
+    float FloorVerticalOffset, float CamCurrentSectorElevationOffset, uint32_t RenderTargetHeight,
+    uint32_t YHigh, uint32_t YLow,
+    float topOffsetPercentage, float bottomOffsetPercentage
+)
+{
+    const auto& [ renderTargetX, depth, normalizedDepth, hitObjectHeight ] = hitProjection;
+    const Scalar objectHeight = ToRasterScalar<Scalar>(hitObjectHeight);
+    const Scalar elevationOffset = ToRasterScalar<Scalar>(CamCurrentSectorElevationOffset);
+
+    // Rendering
+    const Scalar heightDelta = RasterScalarFromInt<Scalar>(RenderTargetHeight) - objectHeight;
+    const Scalar halfHeightDelta = heightDelta / RasterScalarFromInt<Scalar>(2);
+    
+    const Scalar fullSizeTopY = (halfHeightDelta - ToRasterScalar<Scalar>(FloorVerticalOffset));
+    
+    Scalar topY    = fullSizeTopY + (objectHeight * ToRasterScalar<Scalar>(topOffsetPercentage));
+    Scalar bottomY = (fullSizeTopY + objectHeight) - (objectHeight * ToRasterScalar<Scalar>(bottomOffsetPercentage));
+
+    topY += elevationOffset;
+    bottomY += elevationOffset;
+
+    const Scalar yLow = RasterScalarFromInt<Scalar>(YLow);
+    const Scalar yHigh = RasterScalarFromInt<Scalar>(YHigh);
+
+    return {
+        .top    = { static_cast<float>(renderTargetX), RasterScalarToFloat(RasterClamp(topY, yLow, yHigh)) }, 
+        .bottom = { static_cast<float>(renderTargetX), RasterScalarToFloat(RasterClamp(bottomY, yLow, yHigh)) },
+        .depth  = depth,
+        .normalizedDepth = normalizedDepth
+    };
+}
+
+template CameraYLineData ComputeCameraYAxisAs<float>(const ColumnHitProjection& hitProjection,
+    float FloorVerticalOffset, float CamCurrentSectorElevationOffset, uint32_t RenderTargetHeight,
+    uint32_t YHigh, uint32_t YLow, float topOffsetPercentage, float bottomOffsetPercentage);
+template CameraYLineData ComputeCameraYAxisAs<Fixed16>(const ColumnHitProjection& hitProjection,
+    float FloorVerticalOffset, float CamCurrentSectorElevationOffset, uint32_t RenderTargetHeight,
+    uint32_t YHigh, uint32_t YLow, float topOffsetPercentage, float bottomOffsetPercentage);
+
+CameraYLineData ComputeCameraYAxis(
+    const ColumnHitProjection& hitProjection,
+    float FloorVerticalOffset, float CamCurrentSectorElevationOffset, uint32_t RenderTargetHeight,
+    uint32_t YHigh, uint32_t YLow,
+    float topOffsetPercentage, float bottomOffsetPercentage
+)
+{
+    return ComputeCameraYAxisAs<RasterScalar>(hitProjection, FloorVerticalOffset, CamCurrentSectorElevationOffset, RenderTargetHeight,
+        YHigh, YLow, topOffsetPercentage, bottomOffsetPercentage);
+}
+
+void RenderCameraYLine(RasterizeWorldContext& ctx, CameraYLineData renderData, Color color, PaletteIndex colorIndex, bool topEdge, bool bottomEdge)
+{
+    float darkness = Lerp(1, 0, renderData.normalizedDepth);
+
+    DrawShadedColumnSpan(ctx,
+        renderData.top, 
+        renderData.bottom, 
+        color,
+        colorIndex,
+        renderData.normalizedDepth
+    );
+
+    if(topEdge)
+        DrawEdgeMarker(ctx, renderData.top);
+    if(bottomEdge)
+        DrawEdgeMarker(ctx, renderData.bottom);
+}
+
+void RenderTexturedWallColumn(RasterizeWorldContext& ctx, CameraYLineData renderData, const ColumnHitProjection& hitProjection,
+    const WallTextureView& texture, float wallU)
+{
+    switch(ctx.backend)
+    {
+        case RasterizerBackend::Raylib:
+            DrawColumnSpan(ctx, renderData.top, renderData.bottom, ColorDarken(texture.mips[texture.mipsCount - 1].texels[0], renderData.normalizedDepth));
+        break;
+
+        case RasterizerBackend::Framebuffer:
+        {
+            const float objectHeight = std::max(hitProjection.objectHeight, 1.f);
+
+            // Far walls read a smaller level, its texels stay close to one per pixel
+            const WallTextureMipView& mip = texture.mips[SelectWallTextureMip(texture, texture.mips[0].height / objectHeight)];
+
+            const uint32_t u = std::min(static_cast<uint32_t>((wallU - floorf(wallU)) * mip.width), mip.width - 1);
+
+            // Top of the full height wall, same terms as ComputeCameraYAxis
+            const float fullWallTopY = (ctx.RenderTargetHeight - objectHeight) / 2 - ctx.FloorVerticalOffset + ctx.CamCurrentSectorElevationOffset;
+
+            // Same rows as DrawColumnSpan
+            const int32_t yBegin = static_cast<int32_t>(floorf(std::min(renderData.top.y, renderData.bottom.y)));
+            const int32_t yEnd = static_cast<int32_t>(floorf(std::max(renderData.top.y, renderData.bottom.y)));
+            const float vStep = mip.height / objectHeight;
+
+            const float vBegin = (yBegin + 0.5f - fullWallTopY) * vStep;
+
+            if(ctx.framebuffer->format == FramebufferFormat::Palettized)
+            {
+                // "Wall texture not matched to the framebuffer palette"
+                assert(mip.indices != nullptr);
+
+                FillFramebufferColumnTexturedIndex(*ctx.framebuffer, hitProjection.renderTargetX, yBegin, yEnd,
+                    mip.IndexColumn(u), mip.height, vBegin, vStep, ctx.framebuffer->palette->shadeTables[PaletteShadeLevel(renderData.normalizedDepth)].data());
+                break;
+            }
+
+            // Shading is the same for the whole column, ColorDarken as an 8 bit scale
+            const uint32_t light = static_cast<uint32_t>(roundf(256 * (1 - Clamp(renderData.normalizedDepth, 0, 1))));
+
+            FillFramebufferColumnTextured(*ctx.framebuffer, hitProjection.renderTargetX, yBegin, yEnd,
+                mip.Column(u), mip.height, vBegin, vStep, light);
+        }
+        break;
+    }
+
+    DrawEdgeMarker(ctx, renderData.top);
+}
+
+const WallTextureView* FindWallTexture(const RasterizeWorldContext& ctx, WallIndex wallIndex)
+{
+    const WallTextureID textureId = ctx.world->wallTextures[wallIndex];
+
+    if(textureId >= ctx.wallTextures.size() || ctx.wallTextures[textureId].mipsCount == 0) return nullptr;
+
+    return &ctx.wallTextures[textureId];
+}
+
+void RequestSectorWallTextures(RasterizeWorldContext& ctx, SectorIndex sectorIndex)
+{
+    for(WallTextureID textureId : ctx.world->SectorTextures(sectorIndex))
+    {
+        ctx.requestedTextures[textureId >> 6] |= uint64_t(1) << (textureId & 63);
+    }
+}
+
+void DrawColumnSpan(RasterizeWorldContext& ctx, Vector2 top, Vector2 bottom, Color color)
+{
+    switch(ctx.backend)
+    {
+        case RasterizerBackend::Raylib:
+            DrawLineV(top, bottom, color);
+        break;
+
+        // Like DrawLineV the ends may come in any order, solid walls give their floor end as top
+        case RasterizerBackend::Framebuffer:
+            FillFramebufferColumn(*ctx.framebuffer, static_cast<uint32_t>(top.x), 
+                static_cast<int32_t>(floorf(std::min(top.y, bottom.y))), static_cast<int32_t>(floorf(std::max(top.y, bottom.y))), color);
+        break;
+    }
+}
+
+void DrawRowSpan(RasterizeWorldContext& ctx, uint32_t y, uint32_t xBegin, uint32_t xEnd, Color color)
+{
+    switch(ctx.backend)
+    {
+        case RasterizerBackend::Raylib:
+            DrawRectangle(static_cast<int>(xBegin), static_cast<int>(y), static_cast<int>(xEnd - xBegin + 1), 1, color);
+        break;
+
+        case RasterizerBackend::Framebuffer:
+            FillFramebufferRow(*ctx.framebuffer, y, static_cast<int32_t>(xBegin), static_cast<int32_t>(xEnd + 1), color);
+        break;
+    }
+}
+
+void DrawShadedColumnSpan(RasterizeWorldContext& ctx, Vector2 top, Vector2 bottom, Color color, PaletteIndex colorIndex, float normalizedDepth)
+{
+    if(ctx.backend != RasterizerBackend::Framebuffer || ctx.framebuffer->format != FramebufferFormat::Palettized)
+    {
+        DrawColumnSpan(ctx, top, bottom, ColorDarken(color, normalizedDepth));
+        return;
+    }
+
+    const Palette& palette = *ctx.framebuffer->palette;
+
+    // Same rows as DrawColumnSpan
+    FillFramebufferColumnIndex(*ctx.framebuffer, static_cast<uint32_t>(top.x),
+        static_cast<int32_t>(floorf(std::min(top.y, bottom.y))), static_cast<int32_t>(floorf(std::max(top.y, bottom.y))),
+        palette.shadeTables[PaletteShadeLevel(normalizedDepth)][colorIndex]);
+}
+
+void DrawShadedRowSpan(RasterizeWorldContext& ctx, uint32_t y, uint32_t xBegin, uint32_t xEnd, Color color, PaletteIndex colorIndex, float normalizedDepth)
+{
+    if(ctx.backend != RasterizerBackend::Framebuffer || ctx.framebuffer->format != FramebufferFormat::Palettized)
+    {
+        DrawRowSpan(ctx, y, xBegin, xEnd, ColorDarken(color, normalizedDepth));
+        return;
+    }
+
+    const Palette& palette = *ctx.framebuffer->palette;
+
+    FillFramebufferRowIndex(*ctx.framebuffer, y, static_cast<int32_t>(xBegin), static_cast<int32_t>(xEnd + 1),
+        palette.shadeTables[PaletteShadeLevel(normalizedDepth)][colorIndex]);
+}
+
+void DrawEdgeMarker(RasterizeWorldContext& ctx, Vector2 position)
+{
+    // Same int truncation as the DrawRectangle parameters
+    const int32_t posX = static_cast<int32_t>(position.x - 1);
+    const int32_t posY = static_cast<int32_t>(position.y - 1);
+
+    switch(ctx.backend)
+    {
+        case RasterizerBackend::Raylib:
+            DrawRectangle(posX, posY, 3, 3, GRAY);
+        break;
+
+        case RasterizerBackend::Framebuffer:
+            ctx.edgeMarkers.push_back(position);
+        break;
+    }
+}
+
+void FlushEdgeMarkers(RasterizeWorldContext& ctx)
+{
+    for(Vector2 position : ctx.edgeMarkers)
+    {
+        FillFramebufferRectangle(*ctx.framebuffer, static_cast<int32_t>(position.x - 1), static_cast<int32_t>(position.y - 1), 3, 3, GRAY);
+    }
+
+    ctx.edgeMarkers.clear();
+}
+
+std::vector<Color> CollectPaletteColors(const RenderWorld& world, std::span<const WallTextureSource> wallTextures)
+{
+    // Drawn as they are, first so they always keep an exact entry
+    std::vector<Color> colors = { MY_BLACK, FarPlaneFogColor, PURPLE, GRAY };
+
+    for(const RenderSectorColors& sectorColors : world.sectorColors)
+    {
+        colors.insert(colors.end(), { sectorColors.floor, sectorColors.ceiling, sectorColors.topBorder, sectorColors.bottomBorder });
+    }
+
+    colors.insert(colors.end(), world.wallColors.begin(), world.wallColors.end());
+
+    // Once per wall like the colors above, so the palette spends its entries where the world does
+    for(WallTextureID textureId : world.wallTextures)
+    {
+        if(textureId < wallTextures.size() && wallTextures[textureId].path.empty())
+        {
+            colors.insert(colors.end(), { wallTextures[textureId].brickColor, wallTextures[textureId].mortarColor });
+        }
+    }
+
+    return colors;
+}
+
+void ResolvePaletteIndices(const RenderWorld& world, const Palette& palette, RenderWorldPaletteIndices& outIndices)
+{
+    outIndices.sectors.clear();
+
+    for(const RenderSectorColors& sectorColors : world.sectorColors)
+    {
+        outIndices.sectors.push_back({
+            .floor = FindPaletteIndex(palette, sectorColors.floor),
+            .ceiling = FindPaletteIndex(palette, sectorColors.ceiling),
+            .topBorder = FindPaletteIndex(palette, sectorColors.topBorder),
+            .bottomBorder = FindPaletteIndex(palette, sectorColors.bottomBorder),
+        });
+    }
+
+    outIndices.walls.resize(world.wallColors.size());
+
+    for(size_t wallIndex = 0; wallIndex < world.wallColors.size(); ++wallIndex)
+    {
+        outIndices.walls[wallIndex] = FindPaletteIndex(palette, world.wallColors[wallIndex]);
+    }
+}
+
+WorldRasterizer::WorldRasterizer(uint32_t renderTargetWidth, uint32_t renderTargetHeight, const World& world, const RaycastingCamera& cam)
+{
+    Reset(renderTargetWidth, renderTargetHeight, world, cam);
+}
+
+void WorldRasterizer::Reset(uint32_t renderTargetWidth, uint32_t renderTargetHeight, const World &world, const RaycastingCamera &cam)
+{
+    const uint64_t allocationsCountBefore = GetAllocationsCount();
+
+    if(compiledWorldSource != &world || compiledWorldRevision != world.revision)
+    {
+        CompileRenderWorld(world, compiledWorld);
+        SyncWallTextureCacheSources(textureCache, world.wallTextures);
+        isPaletteOutdated = true;
+
+        compiledWorldSource = &world;
+        compiledWorldRevision = world.revision;
+    }
+
+    // Started on layout changes and picked up once done, frames render without the sets until then
+    pvsBuilder.Update(compiledWorld);
+
+    // Textures the last frame visited, loaded between frames so a whole frame reads the same cache state
+    UpdateWallTextureCache(textureCache, ctx.requestedTextures);
+
+    Reset(renderTargetWidth, renderTargetHeight, compiledWorld, cam);
+
+    currentFrame = TakeFrameSnapshot(renderTargetWidth, renderTargetHeight, world, cam);
+    currentFrameTracked = true;
+
+    // The RenderWorld overload restarted the count, add the compilation to it
+    ctx.frameAllocationsCount = GetAllocationsCount() - allocationsCountBefore;
+}
+
+void WorldRasterizer::Reset(uint32_t renderTargetWidth, uint32_t renderTargetHeight, const RenderWorld &world, const RaycastingCamera &cam)
+{
+    const uint64_t allocationsCountBefore = GetAllocationsCount();
+
+    // Only the World overload knows the revision the frame is rendered from
+    currentFrameTracked = false;
+    completedFrameTracked = false;
+
+    ctx.world = &world;
+    ctx.cam = &cam;
+    ctx.FloorVerticalOffset = ComputeVerticalOffset(cam, renderTargetHeight);
+    ctx.CamCurrentSectorElevationOffset = 0; // TODO : ComputeElevationOffset(cam, world, RenderTargetHeight);
+    ctx.RenderTargetWidth = renderTargetWidth;
+    ctx.RenderTargetHeight = renderTargetHeight;
+    ctx.currentRenderItr = 0;
+
+    UpdateProjectionCache(projectionCache, cam, renderTargetWidth);
+    ctx.projection = &projectionCache;
+    ctx.backend = backend;
+    ctx.scheduler = scheduler;
+    ctx.framebuffer = &framebuffer;
+
+    const bool isCompiledWorld = (&world == &compiledWorld);
+    const bool isPalettized = ctx.backend == RasterizerBackend::Framebuffer && framebufferFormat == FramebufferFormat::Palettized;
+
+    if(isPalettized)
+    {
+        // Other RenderWorlds are drawn with the palette built for the last one, their colors go to the nearest entries
+        if(isPaletteOutdated || !palette.IsBuilt())
+        {
+            BuildPalette(palette, CollectPaletteColors(world, isCompiledWorld ? std::span<const WallTextureSource>(textureCache.sources) : std::span<const WallTextureSource>()));
+            SetWallTextureCachePalette(textureCache, &palette);
+            isPaletteOutdated = false;
+            arePaletteIndicesOutdated = true;
+        }
+
+        // Nothing tells when another RenderWorld changes, its indices are resolved every frame
+        if(arePaletteIndicesOutdated || !isCompiledWorld)
+        {
+            ResolvePaletteIndices(world, palette, paletteIndices);
+            arePaletteIndicesOutdated = !isCompiledWorld;
+        }
+    }
+    else if(paletteIndices.sectors.size() != world.sectors.size() || paletteIndices.walls.size() != world.wallColors.size())
+    {
+        // Passed along with the colors whatever the backend, only read by palettized frames
+        paletteIndices.sectors.resize(world.sectors.size());
+        paletteIndices.walls.resize(world.wallColors.size());
+        arePaletteIndicesOutdated = true;
+    }
+
+    ctx.paletteIndices = &paletteIndices;
+
+    if(ctx.backend == RasterizerBackend::Framebuffer)
+    {
+        ResizeFramebuffer(framebuffer, renderTargetWidth, renderTargetHeight, framebufferFormat, &palette);
+    }
+
+    yBoundaries.resize(renderTargetWidth);
+    ctx.yBoundaries = yBoundaries;
+
+    std::fill(yBoundaries.begin(), yBoundaries.end(), MinMax<uint32_t> {
+        .max = renderTargetHeight,
+        .min = 0,
+    });
+
+    const SectorIndex camSectorIndex = world.FindSectorIndex(ctx.cam->currentSectorId);
+
+    // "Try to InitRasterizeWorldContext with an invalid SectorID"
+    assert(camSectorIndex != NULL_SECTOR_INDEX);
+
+    ctx.camSectorIndex = camSectorIndex;
+
+    // Every column starts in the camera sector
+    columnSectors.assign(renderTargetWidth, camSectorIndex);
+    ctx.columnSectors = columnSectors;
+
+    // Every column starts open, the bits of the last word past the width are closed for good
+    closedColumns.assign((renderTargetWidth + 63) / 64, 0);
+    if(renderTargetWidth % 64 != 0)
+    {
+        closedColumns.back() = ~uint64_t(0) << (renderTargetWidth % 64);
+    }
+    ctx.closedColumns = closedColumns;
+    ctx.closedColumnsCount = 0;
+
+    ctx.planeSpanStarts.resize(renderTargetHeight);
+
+    // The cache views follow the World last compiled, other RenderWorlds are drawn without textures
+    ctx.wallTextures = isCompiledWorld ? std::span<const WallTextureView>(textureCache.views) : std::span<const WallTextureView>();
+    ctx.requestedTextures.assign((world.texturesCount + 63) / 64, 0);
+
+    // Worker stats from an older parallel frame must not leak in this one
+    for(RasterizeWorldContext& workerCtx : workerContexts)
+    {
+        workerCtx.tracedColumnsCount = workerCtx.coherentColumnsCount = 0;
+        workerCtx.requestedTextures.assign(ctx.requestedTextures.size(), 0);
+    }
+    ctx.tracedColumnsCount = ctx.coherentColumnsCount = 0;
+
+    // Every container below keeps its capacity, past the first frames Reset does not allocate
+    ctx.frameArena.Reset();
+    ctx.nextAreaSlots.assign(world.sectors.size(), NULL_AREA_SLOT);
+    ctx.renderStack.clear();
+    ctx.edgeMarkers.clear();
+
+    ctx.renderStack.push_back({
+        .sectorIndex = camSectorIndex,
+        .renderArea = {
+            .xBegin = 0,
+            .xEnd = renderTargetWidth > 0 ? (renderTargetWidth - 1) : 0,
+        }
+    });
+
+    ctx.frameAllocationsCount = GetAllocationsCount() - allocationsCountBefore;
+}
+
+void WorldRasterizer::RasterizeWorldInTexture(const RenderTexture& renderTexture)
+{
+    assert(ctx.RenderTargetWidth == renderTexture.texture.width && ctx.RenderTargetHeight == renderTexture.texture.height);
+
+    if(ctx.backend == RasterizerBackend::Framebuffer)
+    {
+        RasterizeWorld();
+        UploadFramebufferToTexture(renderTexture.texture);
+        return;
+    }
+
+    BeginTextureMode(renderTexture);
+        RasterizeWorld();
+    EndTextureMode();
+}
+
+void WorldRasterizer::RasterizeWorld()
+{
+    ClearRenderTarget();
+
+    // A frame already started with RenderIteration() is finished serially
+    if(ctx.backend == RasterizerBackend::Framebuffer && ctx.currentRenderItr == 0)
+    {
+        switch(parallelism)
+        {
+            case RasterizerParallelism::Serial: break;
+            case RasterizerParallelism::ColumnStrips: RasterizeColumnStrips(); return;
+            case RasterizerParallelism::PortalTasks: RasterizePortalTasks(); return;
+        }
+    }
+
+    while(IsRenderIterationRemains()) 
+    {
+        RenderIteration();
+    }
+}
+
+void WorldRasterizer::ClearRenderTarget()
+{
+    switch(ctx.backend)
+    {
+        case RasterizerBackend::Raylib:
+            ClearBackground(MY_BLACK);
+        break;
+
+        case RasterizerBackend::Framebuffer:
+            ClearFramebuffer(framebuffer, MY_BLACK);
+        break;
+    }
+}
+
+void WorldRasterizer::UploadFramebufferToTexture(const Texture2D& texture)
+{
+    // "Only frames rendered with the Framebuffer backend can be uploaded"
+    assert(ctx.backend == RasterizerBackend::Framebuffer);
+
+    UploadFramebuffer(framebuffer, texture);
+}
+
+float WorldRasterizer::GetCoherentColumnsRate() const
+{
+    uint64_t tracedColumnsCount = ctx.tracedColumnsCount;
+    uint64_t coherentColumnsCount = ctx.coherentColumnsCount;
+
+    for(const RasterizeWorldContext& workerCtx : workerContexts)
+    {
+        tracedColumnsCount += workerCtx.tracedColumnsCount;
+        coherentColumnsCount += workerCtx.coherentColumnsCount;
+    }
+
+    return tracedColumnsCount > 0 ? static_cast<float>(coherentColumnsCount) / tracedColumnsCount : 0.f;
+}
+
+bool FrameSnapshot::IsSameFrame(const FrameSnapshot& other) const
+{
+    return world == other.world
+        && worldRevision == other.worldRevision
+        && cam.HasSameRenderState(other.cam)
+        && renderTargetWidth == other.renderTargetWidth
+        && renderTargetHeight == other.renderTargetHeight
+        && mode == other.mode
+        && backend == other.backend
+        && framebufferFormat == other.framebufferFormat
+        && parallelism == other.parallelism
+        && scheduler == other.scheduler;
+}
+
+FrameSnapshot WorldRasterizer::TakeFrameSnapshot(uint32_t renderTargetWidth, uint32_t renderTargetHeight, const World& world, const RaycastingCamera& cam) const
+{
+    return {
+        .world = &world,
+        .worldRevision = world.revision,
+        .cam = cam,
+        .renderTargetWidth = renderTargetWidth,
+        .renderTargetHeight = renderTargetHeight,
+        .mode = ctx.mode,
+        .backend = backend,
+        .framebufferFormat = framebufferFormat,
+        .parallelism = parallelism,
+        .scheduler = scheduler,
+    };
+}
+
+void WorldRasterizer::CompleteFrame()
+{
+    // Workers of a serial frame requested nothing, Reset cleared them
+    for(const RasterizeWorldContext& workerCtx : workerContexts)
+    {
+        for(size_t i = 0; i < ctx.requestedTextures.size(); ++i)
+        {
+            ctx.requestedTextures[i] |= workerCtx.requestedTextures[i];
+        }
+    }
+
+    completedFrame = currentFrame;
+    // Walls drawn flat while their texture was loading must be drawn again once it is loaded
+    completedFrameTracked = currentFrameTracked && !HasMissingWallTextures(textureCache, ctx.requestedTextures);
+}
+
+bool WorldRasterizer::IsFrameUpToDate(uint32_t renderTargetWidth, uint32_t renderTargetHeight, const World& world, const RaycastingCamera& cam) const
+{
+    // A frame in progress has not produced its image yet
+    if(!completedFrameTracked || IsRenderIterationRemains()) return false;
+
+    return completedFrame.IsSameFrame(TakeFrameSnapshot(renderTargetWidth, renderTargetHeight, world, cam));
+}
+
+bool WorldRasterizer::IsRenderIterationRemains() const
+{
+    return !ctx.renderStack.empty();
+}
+
+void WorldRasterizer::RenderIteration()
+{
+    // "Rendering is ended, RenderIteration should not be called"
+    assert(IsRenderIterationRemains());
+
+    const uint64_t allocationsCountBefore = GetAllocationsCount();
+
+    RasterizeInRenderArea(ctx, ctx.renderStack.back());
+    ctx.currentRenderItr++;
+
+    // The whole screen is covered, whatever is left in the stack can't draw anything
+    if(ctx.closedColumnsCount == ctx.RenderTargetWidth)
+    {
+        ctx.renderStack.clear();
+    }
+
+    // Last iteration of the frame
+    if(!IsRenderIterationRemains())
+    {
+        FlushEdgeMarkers(ctx);
+        CompleteFrame();
+    }
+
+    ctx.frameAllocationsCount += GetAllocationsCount() - allocationsCountBefore;
+}
+
+void WorldRasterizer::PrepareWorkerContexts(RenderAreaScheduler workersScheduler)
+{
+    workerContexts.resize(GetJobSystem().GetWorkersCount());
+
+    for(RasterizeWorldContext& workerCtx : workerContexts)
+    {
+        workerCtx.world = ctx.world;
+        workerCtx.cam = ctx.cam;
+        workerCtx.camSectorIndex = ctx.camSectorIndex;
+        workerCtx.RenderTargetWidth = ctx.RenderTargetWidth;
+        workerCtx.RenderTargetHeight = ctx.RenderTargetHeight;
+        workerCtx.FloorVerticalOffset = ctx.FloorVerticalOffset;
+        workerCtx.CamCurrentSectorElevationOffset = ctx.CamCurrentSectorElevationOffset;
+        workerCtx.projection = ctx.projection;
+        workerCtx.mode = ctx.mode;
+        workerCtx.backend = ctx.backend;
+        workerCtx.framebuffer = ctx.framebuffer;
+        workerCtx.yBoundaries = ctx.yBoundaries;
+        workerCtx.columnSectors = ctx.columnSectors;
+        workerCtx.closedColumns = ctx.closedColumns;
+        workerCtx.planeSpanStarts.resize(ctx.RenderTargetHeight);
+        workerCtx.paletteIndices = ctx.paletteIndices;
+        workerCtx.wallTextures = ctx.wallTextures;
+        workerCtx.requestedTextures.assign(ctx.requestedTextures.size(), 0);
+        workerCtx.closedColumnsCount = 0;
+        workerCtx.tracedColumnsCount = workerCtx.coherentColumnsCount = 0;
+        workerCtx.scheduler = workersScheduler;
+        workerCtx.frameAllocationsCount = 0;
+
+        workerCtx.frameArena.Reset();
+        workerCtx.taskArena.Reset();
+        workerCtx.nextAreaSlots.assign(ctx.world->sectors.size(), NULL_AREA_SLOT);
+        workerCtx.renderStack.clear();
+        workerCtx.edgeMarkers.clear();
+    }
+}
+
+uint64_t WorldRasterizer::GetWorkerThreadsAllocationsCount() const
+{
+    // Worker 0 is this thread, its jobs are already in its own count
+    uint64_t allocationsCount = 0;
+    for(size_t workerIndex = 1; workerIndex < workerContexts.size(); workerIndex++)
+    {
+        allocationsCount += workerContexts[workerIndex].frameAllocationsCount;
+    }
+
+    return allocationsCount;
+}
+
+void WorldRasterizer::RasterizeColumnStrips()
+{
+    // "Column strips write the framebuffer from several threads, raylib can't be used there"
+    assert(ctx.backend == RasterizerBackend::Framebuffer);
+
+    const uint64_t allocationsCountBefore = GetAllocationsCount();
+
+    JobSystem& jobSystem = GetJobSystem();
+    PrepareWorkerContexts(ctx.scheduler);
+
+    // A few strips per worker leave room for stealing when some strips see much deeper than others,
+    // strips are kept a multiple of RayPacketSize so packets stay full
+    constexpr uint32_t StripsPerWorker = 4;
+    constexpr uint32_t MinStripWidth = 4 * RayPacketSize;
+
+    struct ColumnStripsJob
+    {
+        std::vector<RasterizeWorldContext>* workerContexts;
+        SectorIndex camSectorIndex;
+        uint32_t stripWidth;
+    };
+
+    const uint32_t stripsCountTarget = jobSystem.GetWorkersCount() * StripsPerWorker;
+    uint32_t stripWidth = (ctx.RenderTargetWidth + stripsCountTarget - 1) / stripsCountTarget;
+    stripWidth = std::max(MinStripWidth, (stripWidth + RayPacketSize - 1) / RayPacketSize * RayPacketSize);
+
+    ColumnStripsJob job {
+        .workerContexts = &workerContexts,
+        .camSectorIndex = ctx.renderStack.front().sectorIndex,
+        .stripWidth = stripWidth,
+    };
+
+    const uint32_t stripsCount = (ctx.RenderTargetWidth + stripWidth - 1) / stripWidth;
+
+    jobSystem.ParallelFor(stripsCount, [](void* data, uint32_t stripIndex, uint32_t workerIndex)
+    {
+        const ColumnStripsJob& job = *static_cast<const ColumnStripsJob*>(data);
+        RasterizeWorldContext& workerCtx = (*job.workerContexts)[workerIndex];
+
+        const uint64_t allocationsCountBefore = GetAllocationsCount();
+
+        const uint32_t xBegin = stripIndex * job.stripWidth;
+
+        workerCtx.renderStack.push_back({
+            .sectorIndex = job.camSectorIndex,
+            .renderArea = {
+                .xBegin = xBegin,
+                .xEnd = std::min(xBegin + job.stripWidth, workerCtx.RenderTargetWidth) - 1,
+            }
+        });
+
+        // The maxPortalDepth budget is applied per column chain, like in serial frames
+        while(!workerCtx.renderStack.empty())
+        {
+            RasterizeInRenderArea(workerCtx, workerCtx.renderStack.back());
+        }
+
+        workerCtx.frameAllocationsCount += GetAllocationsCount() - allocationsCountBefore;
+    }, &job);
+
+    // Every strip is done, markers can cross their borders now
+    for(RasterizeWorldContext& workerCtx : workerContexts)
+    {
+        FlushEdgeMarkers(workerCtx);
+    }
+
+    ctx.renderStack.clear();
+    CompleteFrame();
+
+    ctx.frameAllocationsCount += GetAllocationsCount() - allocationsCountBefore + GetWorkerThreadsAllocationsCount();
+}
+namespace
+{
+    struct PortalTasksFrame
+    {
+        JobSystem* jobSystem { nullptr };
+        std::vector<RasterizeWorldContext>* workerContexts { nullptr };
+        JobCounter* counter { nullptr };
+    };
+
+    struct PortalTask
+    {
+        PortalTasksFrame* frame { nullptr };
+        SectorRenderContext renderContext;
+    };
+
+    // Below this width an area costs less to rasterize than to schedule, it is done in place
+    constexpr uint32_t MinPortalTaskWidth = 4 * RayPacketSize;
+
+    void RunPortalTask(void* data, uint32_t index, uint32_t workerIndex);
+
+    void RasterizePortalTaskArea(PortalTasksFrame& frame, RasterizeWorldContext& workerCtx, SectorRenderContext renderContext, uint32_t workerIndex)
+    {
+        // Children are pushed above stackBase, anything below belongs to the caller
+        const size_t stackBase = workerCtx.renderStack.size();
+
+        // Children past maxPortalDepth are not pushed
+        workerCtx.renderStack.push_back(renderContext);
+        RasterizeInRenderArea(workerCtx, renderContext);
+
+        while(workerCtx.renderStack.size() > stackBase)
+        {
+            const SectorRenderContext child = workerCtx.renderStack.back();
+            workerCtx.renderStack.pop_back();
+
+            if(child.renderArea.xEnd - child.renderArea.xBegin + 1 < MinPortalTaskWidth)
+            {
+                RasterizePortalTaskArea(frame, workerCtx, child, workerIndex);
+                continue;
+            }
+
+            PortalTask& childTask = workerCtx.taskArena.Allocate<PortalTask>(1)[0];
+            childTask = {
+                .frame = &frame,
+                .renderContext = child,
+            };
+
+            frame.jobSystem->Submit({ .function = RunPortalTask, .data = &childTask, .counter = frame.counter }, workerIndex);
+        }
+    }
+
+    // Portal tasks running on this thread, a task submitted to a full queue runs inside the one submitting it
+    thread_local uint32_t runningPortalTasksCount = 0;
+
+    void RunPortalTask(void* data, uint32_t, uint32_t workerIndex)
+    {
+        const PortalTask& task = *static_cast<const PortalTask*>(data);
+        RasterizeWorldContext& workerCtx = (*task.frame->workerContexts)[workerIndex];
+
+        // Only the outermost task counts, its allocations already include the ones of the tasks run inside it
+        const bool isOutermostTask = runningPortalTasksCount++ == 0;
+
+        const uint64_t allocationsCountBefore = GetAllocationsCount();
+        RasterizePortalTaskArea(*task.frame, workerCtx, task.renderContext, workerIndex);
+
+        --runningPortalTasksCount;
+
+        if(isOutermostTask)
+        {
+            workerCtx.frameAllocationsCount += GetAllocationsCount() - allocationsCountBefore;
+        }
+    }
+}
+
+void WorldRasterizer::RasterizePortalTasks()
+{
+    // "Portal tasks write the framebuffer from several threads, raylib can't be used there"
+    assert(ctx.backend == RasterizerBackend::Framebuffer);
+
+    const uint64_t allocationsCountBefore = GetAllocationsCount();
+
+    JobSystem& jobSystem = GetJobSystem();
+
+    // Render areas never share a column, so tasks running at the same time never write the same pixels.
+    // Children are read back from the top of the stack, so they must be pushed depth first.
+    PrepareWorkerContexts(RenderAreaScheduler::DepthFirst);
+
+    JobCounter counter;
+
+    PortalTasksFrame frame {
+        .jobSystem = &jobSystem,
+        .workerContexts = &workerContexts,
+        .counter = &counter,
+    };
+
+    PortalTask rootTask {
+        .frame = &frame,
+        .renderContext = ctx.renderStack.front(),
+    };
+
+    jobSystem.Submit({ .function = RunPortalTask, .data = &rootTask, .counter = &counter }, 0);
+    jobSystem.Wait(counter, 0);
+
+    for(RasterizeWorldContext& workerCtx : workerContexts)
+    {
+        FlushEdgeMarkers(workerCtx);
+    }
+
+    ctx.renderStack.clear();
+    CompleteFrame();
+
+    ctx.frameAllocationsCount += GetAllocationsCount() - allocationsCountBefore + GetWorkerThreadsAllocationsCount();
+}
@@ -1,11 +1,19 @@
 #pragma once
 
 #include <raylib.h>
-#include <stack>
 #include <functional>
+#include <limits>
+#include <span>
+#include <vector>
 
 #include "Renderer/RaycastingCamera.hpp"
 #include "Renderer/World.hpp"
+#include "Renderer/RenderWorld.hpp"
+#include "Renderer/SectorPvs.hpp"
+#include "Renderer/Framebuffer.hpp"
+#include "Renderer/ProjectionCache.hpp"
+#include "Renderer/WallTextureCache.hpp"
+#include "Utils/FrameArena.hpp"
 
 template <typename T>
 struct MinMax
@@ -24,27 +32,259 @@ struct RenderArea
 
 struct SectorRenderContext
 {
-    const SectorID sectorId { 0 };
+    SectorIndex sectorIndex { 0 };
     RenderArea renderArea;
+    // Portals crossed from the camera sector
+    uint32_t depth { 0 };
+    // Nearest portal hit among the area columns
+    float nearestDistance { 0 };
+};
+
+enum class RasterizationMode
+{
+    // Cast one ray per column against every wall of the sector
+    Ray,
+    // Project each wall once per sector visit and only test the columns it covers
+    WallSpan,
+    // Same as Ray but walls are tested a batch at a time by the SIMD kernel
+    SimdBatch,
+    // Adjacent columns are traced together, RayPacketSize rays against one wall at a time
+    RayPacket,
+};
+
+enum class RasterizerBackend
+{
+    // raylib immediate mode draws, must be called between BeginTextureMode / EndTextureMode
+    Raylib,
+    // Spans written in a CPU Framebuffer, no GPU call until it is uploaded
+    Framebuffer,
+};
+
+struct RaycastHitData
+{
+    float distance = std::numeric_limits<float>::max();
+    Vector2 position { 0 };
+    WallIndex wallIndex = NULL_WALL_INDEX;
+};
+
+enum class RasterizerParallelism
+{
+    Serial,
+    // Framebuffer backend only, the render target is split in column strips traversed on the job system
+    ColumnStrips,
+    // Framebuffer backend only, every render area is a job system task, siblings run side by side
+    PortalTasks,
+};
+
+enum class RenderAreaScheduler
+{
+    // Last found render area is visited first
+    DepthFirst,
+    // Render areas are visited one portal depth at a time, nearest first, ties broken by column.
+    // The order only depends on the frame, areas close to the camera cover the screen early.
+    BreadthFirst,
+};
+
+// Palette entries of RenderSectorColors
+struct RenderSectorPaletteIndices
+{
+    PaletteIndex floor;
+    PaletteIndex ceiling;
+    PaletteIndex topBorder;
+    PaletteIndex bottomBorder;
+};
+
+/// Palette entries of the colors of a RenderWorld, indexed like its colors.
+/// Resolved once per palette build, so palettized spans never look colors up.
+struct RenderWorldPaletteIndices
+{
+    std::vector<RenderSectorPaletteIndices> sectors;
+    std::vector<PaletteIndex> walls;
 };
 
 struct RasterizeWorldContext 
 {
-    const World* world          { nullptr };
+    const RenderWorld* world    { nullptr };
     const RaycastingCamera* cam { nullptr };
+    // Sector of cam, portals to sectors outside its potentially visible set are never traced
+    SectorIndex camSectorIndex  { NULL_SECTOR_INDEX };
     uint32_t RenderTargetWidth  { 0 };
     uint32_t RenderTargetHeight { 0 };
     float FloorVerticalOffset               { 0.f };
     float CamCurrentSectorElevationOffset   { 0.f };
+    // Per column ray directions and perspective terms of cam
+    const ProjectionCache* projection { nullptr };
     
+    RasterizationMode mode { RasterizationMode::Ray };
+    RasterizerBackend backend { RasterizerBackend::Raylib };
+    // Render target of the Framebuffer backend
+    Framebuffer* framebuffer { nullptr };
+
+    // Per column state owned by the WorldRasterizer, shared by every context rasterizing the frame.
+    // A column is only ever touched by the context rasterizing it.
+    std::span<MinMaxUint32> yBoundaries;
+    // Sector the column is waiting to be rasterized in, NULL_SECTOR_INDEX once it hit a solid wall.
+    // Render areas only hold columns seen through their portal, the check keeps every column output
+    // depending on its own portal chain alone.
+    std::span<SectorIndex> columnSectors;
+    // One bit per column, 64 columns per word, set once nothing more can be drawn in the column
+    // (solid wall hit, nothing hit, or portal opening squeezed to nothing). Bits past the render target
+    // width are set from the start. Words are shared between neighbour areas, see CloseColumn.
+    std::span<uint64_t> closedColumns;
+
+    // Number of columns this context closed, the whole screen is covered once it reaches the width
+    uint32_t closedColumnsCount { 0 };
+
+    // Ray mode wall coherence stats, columns traced and columns that started from the previous column wall
+    uint32_t tracedColumnsCount { 0 };
+    uint32_t coherentColumnsCount { 0 };
+
     uint32_t currentRenderItr { 0 };
-    std::vector<MinMaxUint32> yBoundaries;
-    std::stack<SectorRenderContext> renderStack;
+    RenderAreaScheduler scheduler { RenderAreaScheduler::DepthFirst };
+    // The area visited next is always at the back. Used as a stack when depth first, as a binary heap
+    // followed by the next area when breadth first. A vector keeps its capacity from one frame to the next.
+    std::vector<SectorRenderContext> renderStack;
+
+    // Per sector visit scratch memory, rewound at the end of every visit
+    FrameArena frameArena;
+    // One slot per sector, index of its last area in NextRenderAreas::areas or NULL_AREA_SLOT
+    std::vector<uint32_t> nextAreaSlots;
+    // PortalTasks storage, lives until the end of the frame
+    FrameArena taskArena;
+
+    // Rows of the visited columns left to the ceiling and to the floor of the sector, indexed from
+    // planeSpansXBegin. They live in frameArena for the current visit only: the area range may hold
+    // columns of other areas, rasterized at the same time by PortalTasks.
+    std::span<MinMaxUint32> ceilingSpans;
+    std::span<MinMaxUint32> floorSpans;
+    uint32_t planeSpansXBegin { 0 };
+    // Column each open plane span of a row started at, one entry per render target row
+    std::vector<uint32_t> planeSpanStarts;
+
+    // Palettized framebuffer entries of the world colors, see ResolvePaletteIndices
+    const RenderWorldPaletteIndices* paletteIndices { nullptr };
+
+    // WallTextureCache views indexed by WallTextureID, they only change between frames
+    std::span<const WallTextureView> wallTextures;
+    // Bitset of the WallTextureIDs of the visited sectors, the cache loads them before the next frame
+    std::vector<uint64_t> requestedTextures;
+
+    // Framebuffer backend edge markers, they overlap the neighbour columns so they are drawn
+    // once every column is done, which keeps the output independent of the visit order
+    std::vector<Vector2> edgeMarkers;
+
+    // Heap allocations made by the last Reset() and render iterations, job system workers included
+    uint64_t frameAllocationsCount { 0 };
+};
+
+constexpr uint32_t NULL_AREA_SLOT = std::numeric_limits<uint32_t>::max();
+
+// Render areas found during one sector visit, in the order they were first seen.
+// Like Build engine clip windows, a sector seen through separated columns gets one area per run of
+// adjacent columns, so the next visits only go over columns that actually see through the portal
+// and no two areas ever share a column.
+struct NextRenderAreas
+{
+    // Frame arena storage, there can't be more areas than the render area has columns
+    std::span<SectorRenderContext> areas;
+    uint32_t areasCount { 0 };
+
+    // Sector -> last area lookup, every slot is back to NULL_AREA_SLOT once the visit is over
+    std::span<uint32_t> areaSlots;
 };
 
+// Columns of a render target covered by a wall, see ProjectSegmentToScreenColumns
+struct WallColumnSpans
+{
+    RenderArea spans[2];
+    uint32_t spansCount { 0 };
+};
+
+// Walls of the visited sector that can win a column of the render area, worked out once per visit.
+// Portals seen from behind and walls projecting outside the render area are left out, the others
+// keep the sector order so nearest hit ties resolve like when every wall is tested.
+// Lives in the frame arena until the end of the visit.
+struct VisibleWalls
+{
+    // RenderWorld index of each visible wall
+    std::span<WallIndex> wallIndices;
+    // Render area columns covered by each visible wall
+    std::span<WallColumnSpans> columnSpans;
+    // The visible walls again for the SIMD kernels, padded like RenderWorld::SectorWalls
+    WallsSoAView walls;
+};
+
+// Visits renderContext, which must be the back of the render stack, pops it and schedules the areas it leads to
 void RasterizeInRenderArea(RasterizeWorldContext& worldContext, SectorRenderContext renderContext);
+// Replaces the back of the render stack by nextAreas and moves the area to visit next at the back
+void ScheduleRenderAreas(RasterizeWorldContext& worldContext, std::span<const SectorRenderContext> nextAreas);
+
+VisibleWalls CullSectorWalls(RasterizeWorldContext& worldContext, SectorIndex sectorIndex, RenderArea renderArea);
+
+constexpr uint32_t NULL_VISIBLE_WALL = std::numeric_limits<uint32_t>::max();
+
+// Visible walls sorted by their distance to the camera, built once per Ray mode visit
+struct VisibleWallsDepthOrder
+{
+    // Positions in VisibleWalls::wallIndices, nearest wall first
+    std::span<uint32_t> order;
+    // Distance from the camera to the nearest point of each visible wall, indexed like VisibleWalls::wallIndices
+    std::span<float> nearestDistances;
+};
+
+VisibleWallsDepthOrder SortVisibleWallsByDepth(RasterizeWorldContext& worldContext, const VisibleWalls& visibleWalls);
 
-void RenderNextAreaBorders(RasterizeWorldContext& worldContext, MinMaxUint32& yMinMax, const Sector& currentSector, const Sector& nextSector, uint32_t x, float hitDistance);
+RasterRay ComputeColumnRay(const RasterizeWorldContext& worldContext, uint32_t x);
+RaycastHitData FindNearestWallHitSimd(const VisibleWalls& visibleWalls, const RasterRay& ray);
+// Sectors with a wall BVH only, see RayToSectorWallBvhNearestHit
+RaycastHitData FindNearestWallHitBvh(const RasterizeWorldContext& worldContext, SectorIndex sectorIndex, const RasterRay& ray);
+// Nearest hit among the visible walls, the first one in sector order on ties. When the ray still hits coherentWall
+// (the wall the previous column hit), only the walls that can be nearer are tested, in depth order.
+// coherentWall is updated for the next column.
+RaycastHitData FindNearestWallHitCoherent(RasterizeWorldContext& worldContext, const VisibleWalls& visibleWalls, 
+    const VisibleWallsDepthOrder& depthOrder, const RasterRay& ray, uint32_t& coherentWall);
+
+// Fills columnHits with the nearest wall hit of each column of the render area
+void ProjectWallSpansInRenderArea(const RasterizeWorldContext& worldContext, const VisibleWalls& visibleWalls, RenderArea renderArea, std::span<RaycastHitData> columnHits);
+// Returns the number of column spans (0 to 2) covered by the segment, spans are inclusive and conservative
+uint32_t ProjectSegmentToScreenColumns(const RaycastingCamera& cam, uint32_t renderTargetWidth, const Segment& segment, RenderArea outSpans[2]);
+
+void RasterizeColumnHit(RasterizeWorldContext& worldContext, SectorIndex currentSectorIndex, uint32_t x, const RaycastHitData& hitData, NextRenderAreas& nextRenderAreas);
+void RasterizeRayPacket(RasterizeWorldContext& worldContext, SectorIndex currentSectorIndex, const VisibleWalls& visibleWalls, uint32_t xBegin, uint32_t lanesCount, NextRenderAreas& nextRenderAreas);
+
+// nextSectorIndex is NULL_SECTOR_INDEX when the hit wall is a solid wall
+void DrawColumnHit(RasterizeWorldContext& worldContext, SectorIndex currentSectorIndex, SectorIndex nextSectorIndex, uint32_t x, const RaycastHitData& hitData);
+void ExtendNextRenderArea(NextRenderAreas& nextRenderAreas, SectorIndex nextSectorIndex, uint32_t xBegin, uint32_t xEnd, float portalDistance);
+
+// ColorDarken fades walls to black at the far plane, sectors past it are filled with the same color
+constexpr Color FarPlaneFogColor = BLACK;
+
+// Fills the column opening with FarPlaneFogColor and closes it, used instead of looking through a portal
+// past the far plane: the whole sector behind it is farther than the portal
+void FillColumnWithFog(RasterizeWorldContext& worldContext, uint32_t x);
+
+// Closed columns bitmask, safe to use from concurrent contexts as long as each column has a single owner
+void CloseColumn(RasterizeWorldContext& worldContext, uint32_t x);
+bool IsColumnClosed(const RasterizeWorldContext& worldContext, uint32_t x);
+// First open column in [x, xEnd], xEnd + 1 when there is none
+uint32_t NextOpenColumn(const RasterizeWorldContext& worldContext, uint32_t x, uint32_t xEnd);
+// Shrinks renderArea to its first and last open columns, false when every column is closed
+bool TrimRenderAreaToOpenColumns(const RasterizeWorldContext& worldContext, RenderArea& renderArea);
+
+// coveredRows receives the rows drawn as borders or left to the next sector
+void RenderNextAreaBorders(RasterizeWorldContext& worldContext, MinMaxUint32& yMinMax, SectorIndex currentSectorIndex, SectorIndex nextSectorIndex, uint32_t x, float hitDistance,
+    MinMaxUint32& coveredRows);
+
+// Visplanes, the rows of a column above and below coveredRows go to the ceiling and floor of the visited sector
+void SetColumnPlaneSpans(RasterizeWorldContext& worldContext, uint32_t x, MinMaxUint32 window, MinMaxUint32 coveredRows);
+// Fills the ceiling and floor spans the visit left in renderArea, one horizontal span per row run
+void DrawSectorPlanes(RasterizeWorldContext& worldContext, SectorIndex sectorIndex, RenderArea renderArea);
+// planeZ is the zFloor or zCeiling of the sector, see PlaneRowNormalizedDepth
+void DrawPlaneSpans(RasterizeWorldContext& worldContext, std::span<const MinMaxUint32> columnSpans, RenderArea renderArea, Color color, PaletteIndex colorIndex,
+    bool isFloor, float planeZ);
+// Rows of a floor or ceiling are at a constant distance, 0 at the camera and 1 at the far plane or the horizon.
+// planeZ is the sector zFloor or zCeiling, in the same wall height fractions as ComputeCameraYAxis (1 is a full height wall).
+float PlaneRowNormalizedDepth(const RasterizeWorldContext& worldContext, uint32_t y, bool isFloor, float planeZ);
 struct CameraYLineData
 {
     Vector2 top;
@@ -53,6 +293,26 @@ struct CameraYLineData
     float normalizedDepth = 0;
 };
 
+// Perspective projection of a wall hit, shared by every line cut in the same column hit
+struct ColumnHitProjection
+{
+    uint32_t renderTargetX { 0 };
+    float depth = 0;
+    float normalizedDepth = 0;
+    // Screen height of a full height wall at depth
+    float objectHeight = 0;
+};
+
+// The *As functions compute with Scalar, float and Fixed16 are instantiated in every build so both can be
+// compared, the other overloads use RasterScalar
+
+template<typename Scalar>
+ColumnHitProjection ProjectColumnHitAs(const RaycastingCamera& cam, uint32_t renderTargetX, float hitDistance, float rayCosine, uint32_t RenderTargetHeight);
+
+ColumnHitProjection ProjectColumnHit(const RaycastingCamera& cam, uint32_t renderTargetX, float hitDistance, float rayCosine, uint32_t RenderTargetHeight);
+// Reads the column cosine from worldContext.projection
+ColumnHitProjection ProjectColumnHit(const RasterizeWorldContext& worldContext, uint32_t renderTargetX, float hitDistance);
+
 CameraYLineData ComputeCameraYAxis(
     const RaycastingCamera& cam, uint32_t renderTargetX, float hitDistance, 
     float FloorVerticalOffset, float CamCurrentSectorElevationOffset,
@@ -61,10 +321,78 @@ CameraYLineData ComputeCameraYAxis(
     float topOffsetPercentage = 0, float bottomOffsetPercentage = 0
 );
 
+CameraYLineData ComputeCameraYAxis(
+    const RasterizeWorldContext& worldContext, const ColumnHitProjection& hitProjection,
+    uint32_t YHigh, uint32_t YLow,
+    float topOffsetPercentage = 0, float bottomOffsetPercentage = 0
+);
+
+template<typename Scalar>
+CameraYLineData ComputeCameraYAxisAs(
+    const ColumnHitProjection& hitProjection,
+    float FloorVerticalOffset, float CamCurrentSectorElevationOffset, uint32_t RenderTargetHeight,
+    uint32_t YHigh, uint32_t YLow,
+    float topOffsetPercentage, float bottomOffsetPercentage
+);
+
+CameraYLineData ComputeCameraYAxis(
+    const ColumnHitProjection& hitProjection,
+    float FloorVerticalOffset, float CamCurrentSectorElevationOffset, uint32_t RenderTargetHeight,
+    uint32_t YHigh, uint32_t YLow,
+    float topOffsetPercentage = 0, float bottomOffsetPercentage = 0
+);
+
+template<typename Scalar>
+float ComputeVerticalOffsetAs(const RaycastingCamera& cam, uint32_t RenderTargetHeight);
+
 float ComputeVerticalOffset(const RaycastingCamera& cam, uint32_t RenderTargetHeight);
 float ComputeElevationOffset(const RaycastingCamera& cam, const World& world, uint32_t RenderTargetHeight);
 
-void RenderCameraYLine(CameraYLineData renderData, Color color, bool topBorder = true, bool bottomBorder = false);
+// colorIndex is the palette entry of color, see RenderWorldPaletteIndices
+void RenderCameraYLine(RasterizeWorldContext& worldContext, CameraYLineData renderData, Color color, PaletteIndex colorIndex, bool topBorder = true, bool bottomBorder = false);
+/// @brief Solid wall column sampled from texture, the mip level comes from the wall screen height (so from the hit distance)
+/// The Raylib backend draws the 1x1 mip color, sampling texels there would mean one draw call per pixel.
+/// @param wallU position of the hit along the wall in texture widths, only the fractional part is used
+void RenderTexturedWallColumn(RasterizeWorldContext& worldContext, CameraYLineData renderData, const ColumnHitProjection& hitProjection,
+    const WallTextureView& texture, float wallU);
+// Loaded texture of the wall, nullptr when it has none or it is not loaded yet (drawn with its color meanwhile)
+const WallTextureView* FindWallTexture(const RasterizeWorldContext& worldContext, WallIndex wallIndex);
+// Records the textures of the sector walls in worldContext.requestedTextures
+void RequestSectorWallTextures(RasterizeWorldContext& worldContext, SectorIndex sectorIndex);
+
+// Every rasterizer output goes through these, they dispatch on worldContext.backend
+void DrawColumnSpan(RasterizeWorldContext& worldContext, Vector2 top, Vector2 bottom, Color color);
+// Columns [xBegin, xEnd] of row y
+void DrawRowSpan(RasterizeWorldContext& worldContext, uint32_t y, uint32_t xBegin, uint32_t xEnd, Color color);
+// Same as above with color darkened by normalizedDepth, a palettized framebuffer shades colorIndex (the palette entry of color) instead
+void DrawShadedColumnSpan(RasterizeWorldContext& worldContext, Vector2 top, Vector2 bottom, Color color, PaletteIndex colorIndex, float normalizedDepth);
+void DrawShadedRowSpan(RasterizeWorldContext& worldContext, uint32_t y, uint32_t xBegin, uint32_t xEnd, Color color, PaletteIndex colorIndex, float normalizedDepth);
+// 3x3 gray square marking a sector edge
+void DrawEdgeMarker(RasterizeWorldContext& worldContext, Vector2 position);
+// Draws and clears the edge markers deferred by the Framebuffer backend
+void FlushEdgeMarkers(RasterizeWorldContext& worldContext);
+// Colors the palettized framebuffer palette is built from: the unshaded colors of the rasterizer, the world ones
+// and those of the procedural wall textures. Image textures are matched to the nearest entries.
+std::vector<Color> CollectPaletteColors(const RenderWorld& world, std::span<const WallTextureSource> wallTextures);
+/// @brief Fills outIndices with the palette entries of the world sector and wall colors
+void ResolvePaletteIndices(const RenderWorld& world, const Palette& palette, RenderWorldPaletteIndices& outIndices);
+
+// Everything the output of a frame depends on, frames with the same snapshot render the same image
+struct FrameSnapshot
+{
+    const World* world { nullptr };
+    uint64_t worldRevision { 0 };
+    RaycastingCamera cam;
+    uint32_t renderTargetWidth  { 0 };
+    uint32_t renderTargetHeight { 0 };
+    RasterizationMode mode { RasterizationMode::Ray };
+    RasterizerBackend backend { RasterizerBackend::Raylib };
+    FramebufferFormat framebufferFormat { FramebufferFormat::RGBA };
+    RasterizerParallelism parallelism { RasterizerParallelism::Serial };
+    RenderAreaScheduler scheduler { RenderAreaScheduler::DepthFirst };
+
+    bool IsSameFrame(const FrameSnapshot& other) const;
+};
 
 class WorldRasterizer
 {
@@ -73,16 +401,99 @@ public:
     WorldRasterizer(WorldRasterizer&& other) = delete;
 
     WorldRasterizer(uint32_t renderTargetWidth, uint32_t renderTargetHeight, const World& world, const RaycastingCamera& cam);
+    // Compiles world into the rasterizer own RenderWorld when it changed since the last compilation
     void Reset(uint32_t renderTargetWidth, uint32_t renderTargetHeight, const World& world, const RaycastingCamera& cam);
+    // Renders from an already compiled RenderWorld, it must stay alive until the frame is rasterized
+    void Reset(uint32_t renderTargetWidth, uint32_t renderTargetHeight, const RenderWorld& renderWorld, const RaycastingCamera& cam);
 
     bool IsRenderIterationRemains() const;
 
+    // True when the last completed frame was rendered from the same world revision, camera and options,
+    // its output can then be reused as is. Frames rendered from a RenderWorld are never up to date.
+    bool IsFrameUpToDate(uint32_t renderTargetWidth, uint32_t renderTargetHeight, const World& world, const RaycastingCamera& cam) const;
+
+    void SetRasterizationMode(RasterizationMode mode) { ctx.mode = mode; }
+    RasterizationMode GetRasterizationMode() const { return ctx.mode; }
+
+    // Takes effect on the next Reset, a frame is always rendered with a single backend
+    void SetBackend(RasterizerBackend newBackend) { backend = newBackend; }
+    RasterizerBackend GetBackend() const { return backend; }
+
+    // Takes effect on the next Reset, Framebuffer backend only. The palette is built from the colors of the world.
+    void SetFramebufferFormat(FramebufferFormat newFormat) { framebufferFormat = newFormat; }
+    FramebufferFormat GetFramebufferFormat() const { return framebufferFormat; }
+
+    // Only used by RasterizeWorld() with the Framebuffer backend, RenderIteration() is always serial
+    void SetParallelism(RasterizerParallelism newParallelism) { parallelism = newParallelism; }
+    RasterizerParallelism GetParallelism() const { return parallelism; }
+
+    // Takes effect on the next Reset, PortalTasks always go depth first
+    void SetScheduler(RenderAreaScheduler newScheduler) { scheduler = newScheduler; }
+    RenderAreaScheduler GetScheduler() const { return scheduler; }
+
     void RasterizeWorldInTexture(const RenderTexture& renderTexture);
     void RasterizeWorld();
     void RenderIteration();
 
+    // ClearBackground or framebuffer clear, depending on the backend of the current frame
+    void ClearRenderTarget();
+    // Framebuffer backend only, see UploadFramebuffer
+    void UploadFramebufferToTexture(const Texture2D& texture);
+
     const RasterizeWorldContext& GetContext() const { return ctx; }
+    const WallTextureCache& GetWallTextureCache() const { return textureCache; }
+    // Takes effect on the next Reset, the least recently used textures are evicted to go under it
+    void SetWallTextureCacheBudget(size_t budgetBytes) { textureCache.budgetBytes = budgetBytes; }
+    const Framebuffer& GetFramebuffer() const { return framebuffer; }
+    // True while the potentially visible sets of the compiled world are built, frames don't cull with them meanwhile
+    bool IsBuildingPvs() const { return pvsBuilder.IsBuilding(); }
+    uint64_t GetFrameAllocationsCount() const { return ctx.frameAllocationsCount; }
+    // Share of the traced columns of the last frame that took the wall coherence fast path, Ray mode only
+    float GetCoherentColumnsRate() const;
 
 private:
+    FrameSnapshot TakeFrameSnapshot(uint32_t renderTargetWidth, uint32_t renderTargetHeight, const World& world, const RaycastingCamera& cam) const;
+    // Called once the last iteration of a frame is done
+    void CompleteFrame();
+
+    void PrepareWorkerContexts(RenderAreaScheduler workersScheduler);
+    // Heap allocations the jobs of the last parallel frame made on the other threads
+    uint64_t GetWorkerThreadsAllocationsCount() const;
+    void RasterizeColumnStrips();
+    void RasterizePortalTasks();
+
     RasterizeWorldContext ctx;
+    RasterizerBackend backend { RasterizerBackend::Raylib };
+    FramebufferFormat framebufferFormat { FramebufferFormat::RGBA };
+    RasterizerParallelism parallelism { RasterizerParallelism::Serial };
+    RenderAreaScheduler scheduler { RenderAreaScheduler::DepthFirst };
+    Framebuffer framebuffer;
+    // Palettized framebuffer palette, rebuilt by the first palettized frame after a world compilation
+    Palette palette;
+    bool isPaletteOutdated { true };
+    // Entries of the colors of the world being drawn, resolved on palette builds (every frame for other RenderWorlds)
+    RenderWorldPaletteIndices paletteIndices;
+    bool arePaletteIndicesOutdated { true };
+    ProjectionCache projectionCache;
+
+    std::vector<MinMaxUint32> yBoundaries;
+    std::vector<SectorIndex> columnSectors;
+    std::vector<uint64_t> closedColumns;
+    // One per job system worker, they share the frame parameters and per column state of ctx
+    std::vector<RasterizeWorldContext> workerContexts;
+
+    // Snapshot of the frame being rendered and of the last one rendered to the end
+    FrameSnapshot currentFrame;
+    FrameSnapshot completedFrame;
+    bool currentFrameTracked { false };
+    bool completedFrameTracked { false };
+
+    RenderWorld compiledWorld;
+    const World* compiledWorldSource { nullptr };
+    uint64_t compiledWorldRevision { 0 };
+    // Builds the sets of compiledWorld in the background, updated by the World overload of Reset
+    SectorPvsBuilder pvsBuilder;
+
+    // Texels of World::wallTextures, updated by the World overload of Reset
+    WallTextureCache textureCache;
 };
\ No newline at end of file
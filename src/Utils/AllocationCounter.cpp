@@ -0,0 +1,95 @@
+#include "AllocationCounter.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // Per thread, constant initialized so reading it never allocates
+    thread_local uint64_t allocationsCount = 0;
+
+    void* CountedAlloc(std::size_t size)
+    {
+        ++allocationsCount;
+        return std::malloc(size > 0 ? size : 1);
+    }
+
+    void* CountedAlignedAlloc(std::size_t size, std::align_val_t alignment)
+    {
+        ++allocationsCount;
+
+        size = (size > 0) ? size : 1;
+#if defined(_MSC_VER)
+        return _aligned_malloc(size, static_cast<std::size_t>(alignment));
+#else
+        void* memory = nullptr;
+        if(posix_memalign(&memory, static_cast<std::size_t>(alignment), size) != 0)
+            return nullptr;
+        return memory;
+#endif
+    }
+
+    void AlignedFree(void* memory)
+    {
+#if defined(_MSC_VER)
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+}
+
+uint64_t GetAllocationsCount()
+{
+    return allocationsCount;
+}
+
+// Global replacements, the array and nothrow forms end up here as well
+
+void* operator new(std::size_t size)
+{
+    if(void* memory = CountedAlloc(size))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedAlloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return CountedAlloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if(void* memory = CountedAlignedAlloc(size, alignment))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::align_val_t) noexcept { AlignedFree(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { AlignedFree(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { AlignedFree(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { AlignedFree(memory); }
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Number of global operator new calls the calling thread made since it started
+/// Counted by the operator new replacement in AllocationCounter.cpp, compare two reads to know
+/// how many heap allocations the thread made in between. Other threads are never counted, jobs
+/// measure their own thread and report it to the thread that waits for them.
+uint64_t GetAllocationsCount();
@@ -0,0 +1,77 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define RAYCASTING_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#endif
+
+// MSVC lets any function use any intrinsic, GCC / Clang need the instruction set on the function
+#if defined(RAYCASTING_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define RAYCASTING_TARGET(instructionSet) __attribute__((target(instructionSet)))
+#else
+    #define RAYCASTING_TARGET(instructionSet)
+#endif
+
+enum class SimdLevel
+{
+    Scalar,
+    SSE4,
+    AVX2,
+};
+
+inline SimdLevel DetectSimdLevel()
+{
+#if defined(RAYCASTING_X86)
+    bool sse41 = false;
+    bool avx2 = false;
+
+    #if defined(_MSC_VER)
+        int cpuInfo[4];
+        __cpuid(cpuInfo, 0);
+        const int maxLeaf = cpuInfo[0];
+
+        __cpuid(cpuInfo, 1);
+        sse41 = (cpuInfo[2] & (1 << 19)) != 0;
+        const bool osxsave = (cpuInfo[2] & (1 << 27)) != 0;
+        const bool avx = (cpuInfo[2] & (1 << 28)) != 0;
+
+        // The OS must save the YMM registers as well
+        if(maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+        {
+            __cpuidex(cpuInfo, 7, 0);
+            avx2 = (cpuInfo[1] & (1 << 5)) != 0;
+        }
+    #else
+        __builtin_cpu_init();
+        sse41 = __builtin_cpu_supports("sse4.1");
+        avx2 = __builtin_cpu_supports("avx2");
+    #endif
+
+    if(avx2) return SimdLevel::AVX2;
+    if(sse41) return SimdLevel::SSE4;
+#endif
+
+    return SimdLevel::Scalar;
+}
+
+// Detected once, the result can not change while the program runs
+inline SimdLevel GetSimdLevel()
+{
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+inline const char* SimdLevelName(SimdLevel level)
+{
+    switch(level)
+    {
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::SSE4: return "SSE4.1";
+        case SimdLevel::Scalar: break;
+    }
+
+    return "Scalar";
+}
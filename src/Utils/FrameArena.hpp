@@ -0,0 +1,128 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <span>
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+#include <bit>
+#include <type_traits>
+
+/// Bump allocator for memory that only lives during one frame.
+/// Allocations are never freed one by one, Rewind() or Reset() drop them all at once.
+/// When a frame asks for more than the buffer holds the extra blocks come from the heap,
+/// and the next Reset() grows the buffer so the following frames fit in it again.
+class FrameArena
+{
+public:
+    // Drops every allocation, to be called between frames
+    void Reset()
+    {
+        if(!overflowBlocks.empty())
+        {
+            // Rounded up to a power of two so a slowly growing peak does not reallocate every frame
+            buffer.resize(std::bit_ceil(peakOffset));
+            overflowBlocks.clear();
+        }
+
+        overflowBlocksUsed = 0;
+        overflowBlockOffset = 0;
+
+        offset = 0;
+        peakOffset = 0;
+    }
+
+    template <typename T>
+    std::span<T> Allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "FrameArena never runs destructors");
+        static_assert(alignof(T) <= alignof(std::max_align_t));
+
+        const size_t size = count * sizeof(T);
+        const size_t alignedOffset = (offset + alignof(T) - 1) & ~(alignof(T) - 1);
+
+        // offset keeps counting past the buffer so Reset() knows how much the frame really needed
+        offset = alignedOffset + size;
+        peakOffset = std::max(peakOffset, offset);
+
+        std::byte* memory = nullptr;
+
+        if(offset <= buffer.size())
+        {
+            memory = buffer.data() + alignedOffset;
+        }
+        else
+        {
+            // Overflow blocks are carved the same way, a new one is only needed once the last one is full
+            size_t blockOffset = (overflowBlockOffset + alignof(T) - 1) & ~(alignof(T) - 1);
+
+            if(overflowBlocksUsed == 0 || blockOffset + size > overflowBlocks[overflowBlocksUsed - 1].size)
+            {
+                // Blocks dropped by Rewind() are kept and reused when they are large enough
+                if(overflowBlocksUsed == overflowBlocks.size() || overflowBlocks[overflowBlocksUsed].size < size)
+                {
+                    const size_t blockSize = std::max({ size, buffer.size(), MinOverflowBlockSize });
+                    OverflowBlock block { std::make_unique<std::byte[]>(blockSize), blockSize };
+
+                    if(overflowBlocksUsed == overflowBlocks.size())
+                        overflowBlocks.push_back(std::move(block));
+                    else
+                        overflowBlocks[overflowBlocksUsed] = std::move(block);
+                }
+
+                ++overflowBlocksUsed;
+                blockOffset = 0;
+            }
+
+            memory = overflowBlocks[overflowBlocksUsed - 1].memory.get() + blockOffset;
+            overflowBlockOffset = blockOffset + size;
+        }
+
+        T* data = reinterpret_cast<T*>(memory);
+        std::uninitialized_default_construct_n(data, count);
+
+        return { data, count };
+    }
+
+    // Position of the arena, in the buffer and in the overflow blocks
+    struct Marker
+    {
+        size_t offset { 0 };
+        size_t overflowBlocksUsed { 0 };
+        size_t overflowBlockOffset { 0 };
+    };
+
+    Marker GetMarker() const { return { offset, overflowBlocksUsed, overflowBlockOffset }; }
+
+    // Drops the allocations made since marker was taken
+    void Rewind(const Marker& marker)
+    {
+        // "Marker taken after the current position"
+        assert(marker.offset <= offset && marker.overflowBlocksUsed <= overflowBlocksUsed);
+
+        offset = marker.offset;
+        overflowBlocksUsed = marker.overflowBlocksUsed;
+        overflowBlockOffset = marker.overflowBlockOffset;
+    }
+
+    size_t GetCapacity() const { return buffer.size(); }
+
+private:
+    static constexpr size_t MinOverflowBlockSize = 4096;
+
+    struct OverflowBlock
+    {
+        std::unique_ptr<std::byte[]> memory;
+        size_t size { 0 };
+    };
+
+    std::vector<std::byte> buffer;
+    // Only the first overflowBlocksUsed blocks hold allocations, the last of them up to overflowBlockOffset
+    std::vector<OverflowBlock> overflowBlocks;
+    size_t overflowBlocksUsed { 0 };
+    size_t overflowBlockOffset { 0 };
+
+    size_t offset { 0 };
+    size_t peakOffset { 0 };
+};
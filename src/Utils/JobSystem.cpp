@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <cassert>
+
+#include "Utils/JobSystem.hpp"
+
+JobSystem::JobSystem(uint32_t threadsCount)
+{
+    if(threadsCount == 0)
+    {
+        threadsCount = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    queues.reserve(threadsCount);
+    for(uint32_t i = 0; i < threadsCount; ++i)
+    {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    // Worker 0 is the calling thread
+    threads.reserve(threadsCount - 1);
+    for(uint32_t workerIndex = 1; workerIndex < threadsCount; ++workerIndex)
+    {
+        threads.emplace_back(&JobSystem::WorkerLoop, this, workerIndex);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock(wakeMutex);
+        stopRequested = true;
+    }
+    wakeCondition.notify_all();
+
+    for(std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void JobSystem::Submit(const Job& job, uint32_t workerIndex)
+{
+    // "Submitted job must have a function and a counter"
+    assert(job.function != nullptr && job.counter != nullptr);
+
+    job.counter->pendingJobsCount.fetch_add(1, std::memory_order_relaxed);
+
+    // Counted before the push so a thief never sees the job before the count
+    queuedJobsCount.fetch_add(1, std::memory_order_release);
+
+    if(!TryPush(job, workerIndex))
+    {
+        queuedJobsCount.fetch_sub(1, std::memory_order_relaxed);
+        Run(job, workerIndex);
+        return;
+    }
+
+    // Taking the lock makes sure a worker about to sleep sees the new job
+    {
+        std::lock_guard lock(wakeMutex);
+    }
+    wakeCondition.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& counter, uint32_t workerIndex)
+{
+    while(counter.pendingJobsCount.load(std::memory_order_acquire) > 0)
+    {
+        if(!TryRunOneJob(workerIndex))
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::ParallelFor(uint32_t count, JobFunction function, void* data)
+{
+    JobCounter counter;
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        // Pushed in reverse so the owner pops them in order while thieves take the last ones
+        Submit({ .function = function, .data = data, .index = count - 1 - i, .counter = &counter }, 0);
+    }
+
+    Wait(counter, 0);
+}
+
+bool JobSystem::TryPush(const Job& job, uint32_t workerIndex)
+{
+    WorkerQueue& queue = *queues[workerIndex];
+    std::lock_guard lock(queue.mutex);
+
+    if(queue.count == QueueCapacity) return false;
+
+    queue.jobs[(queue.head + queue.count) % QueueCapacity] = job;
+    ++queue.count;
+
+    return true;
+}
+
+bool JobSystem::TryPop(Job& outJob, uint32_t workerIndex)
+{
+    WorkerQueue& queue = *queues[workerIndex];
+    std::lock_guard lock(queue.mutex);
+
+    if(queue.count == 0) return false;
+
+    --queue.count;
+    outJob = queue.jobs[(queue.head + queue.count) % QueueCapacity];
+
+    return true;
+}
+
+bool JobSystem::TrySteal(Job& outJob, uint32_t thiefIndex)
+{
+    const uint32_t workersCount = GetWorkersCount();
+
+    for(uint32_t offset = 1; offset < workersCount; ++offset)
+    {
+        WorkerQueue& queue = *queues[(thiefIndex + offset) % workersCount];
+        std::lock_guard lock(queue.mutex);
+
+        if(queue.count == 0) continue;
+
+        outJob = queue.jobs[queue.head];
+        queue.head = (queue.head + 1) % QueueCapacity;
+        --queue.count;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool JobSystem::TryRunOneJob(uint32_t workerIndex)
+{
+    Job job;
+    if(!TryPop(job, workerIndex) && !TrySteal(job, workerIndex))
+        return false;
+
+    queuedJobsCount.fetch_sub(1, std::memory_order_relaxed);
+    Run(job, workerIndex);
+
+    return true;
+}
+
+void JobSystem::Run(const Job& job, uint32_t workerIndex)
+{
+    job.function(job.data, job.index, workerIndex);
+    job.counter->pendingJobsCount.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::WorkerLoop(uint32_t workerIndex)
+{
+    while(true)
+    {
+        if(TryRunOneJob(workerIndex)) continue;
+
+        std::unique_lock lock(wakeMutex);
+        wakeCondition.wait(lock, [this]()
+        {
+            return stopRequested || queuedJobsCount.load(std::memory_order_acquire) > 0;
+        });
+
+        if(stopRequested) return;
+    }
+}
+
+JobSystem& GetJobSystem()
+{
+    static JobSystem jobSystem;
+    return jobSystem;
+}
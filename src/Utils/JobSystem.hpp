@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// function(data, index, workerIndex), workerIndex identifies the thread running the job (0 is the thread calling Wait)
+using JobFunction = void(*)(void* data, uint32_t index, uint32_t workerIndex);
+
+// Number of submitted jobs not finished yet, Wait() returns once it reaches 0
+struct JobCounter
+{
+    std::atomic<uint32_t> pendingJobsCount { 0 };
+};
+
+struct Job
+{
+    JobFunction function { nullptr };
+    void* data           { nullptr };
+    uint32_t index       { 0 };
+    JobCounter* counter  { nullptr };
+};
+
+/// Fixed pool of worker threads with one job queue each.
+/// Jobs are pushed to the queue of the submitting worker and popped back from it (last in first out),
+/// idle workers steal the oldest jobs of the other queues. Queues are fixed size rings, submitting
+/// and running jobs never allocates, a job submitted to a full queue simply runs in place.
+/// Worker 0 is the thread calling Wait(), only one thread at a time may use it.
+class JobSystem
+{
+public:
+    // threadsCount counts the calling thread, 0 uses every hardware thread
+    explicit JobSystem(uint32_t threadsCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    uint32_t GetWorkersCount() const { return static_cast<uint32_t>(queues.size()); }
+
+    // Can be called from inside a job, workerIndex being the one the job received
+    void Submit(const Job& job, uint32_t workerIndex = 0);
+    // Runs queued jobs until counter reaches 0
+    void Wait(JobCounter& counter, uint32_t workerIndex = 0);
+
+    // Runs function(data, i, workerIndex) for every i in [0, count[ and waits for all of them
+    void ParallelFor(uint32_t count, JobFunction function, void* data);
+
+private:
+    static constexpr uint32_t QueueCapacity = 1024;
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        Job jobs[QueueCapacity];
+        uint32_t head { 0 };  // oldest job, stolen first
+        uint32_t count { 0 };
+    };
+
+    bool TryPush(const Job& job, uint32_t workerIndex);
+    bool TryPop(Job& outJob, uint32_t workerIndex);
+    bool TrySteal(Job& outJob, uint32_t thiefIndex);
+    bool TryRunOneJob(uint32_t workerIndex);
+    void Run(const Job& job, uint32_t workerIndex);
+    void WorkerLoop(uint32_t workerIndex);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::atomic<uint32_t> queuedJobsCount { 0 };
+    std::atomic<bool> stopRequested { false };
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+};
+
+/// @brief Process wide job system, created on first use with every hardware thread
+JobSystem& GetJobSystem();
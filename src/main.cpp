@@ -68,6 +68,9 @@ int main()
         { 550, 600 },
     };
 
+    // Position cam.currentSectorId was last resolved for
+    Vector2 camTrackedPosition = cam.position;
+
     RaycastingCameraViewport cameraViewport(1920, 1080);
     WorldEditor worldEditor(world, cam.position);
 
@@ -89,12 +92,10 @@ int main()
         }
 
         {
-            // Update current sector
-            uint32_t currentSectorId = FindSectorOfPoint(cam.position, world);
-            if(currentSectorId != NULL_SECTOR)
-            {
-                cam.currentSectorId = currentSectorId;
-            }
+            // Update current sector, follow the portals crossed since the last frame
+            world.UpdateSpatialIndex();
+            cam.currentSectorId = TrackSectorOfMovingPoint(cam.currentSectorId, camTrackedPosition, cam.position, world);
+            camTrackedPosition = cam.position;
         }
 
         if(cameraViewport.IsFocused())
@@ -0,0 +1,111 @@
+// FrameArena markers and rewinds, within the buffer and across overflow blocks
+
+#include <cstdint>
+
+#include "Utils/AllocationCounter.hpp"
+#include "Utils/FrameArena.hpp"
+#include "TestHelpers.hpp"
+
+// Allocations well past the buffer, spread over several overflow blocks
+void AllocateScratch(FrameArena& arena)
+{
+    for(uint32_t k = 0; k < 20; ++k)
+    {
+        for(uint64_t& value : arena.Allocate<uint64_t>(300 + k * 37)) value = 0xdeadbeefcafebabeULL;
+    }
+}
+
+void TestRewindKeepsEarlierAllocations()
+{
+    FrameArena arena;
+
+    for(uint32_t frame = 0; frame < 4; ++frame)
+    {
+        arena.Reset();
+
+        std::span<uint32_t> kept = arena.Allocate<uint32_t>(100);
+        for(uint32_t i = 0; i < kept.size(); ++i) kept[i] = i;
+
+        const FrameArena::Marker marker = arena.GetMarker();
+        AllocateScratch(arena);
+        arena.Rewind(marker);
+
+        // The memory after the marker is handed out again, the one before is untouched
+        const uint64_t* rewoundData = arena.Allocate<uint64_t>(300).data();
+        arena.Rewind(marker);
+
+        for(uint32_t rep = 0; rep < 50; ++rep)
+        {
+            const FrameArena::Marker repMarker = arena.GetMarker();
+            AllocateScratch(arena);
+            arena.Rewind(repMarker);
+        }
+
+        TEST_CHECK(arena.Allocate<uint64_t>(300).data() == rewoundData);
+
+        std::span<uint32_t> after = arena.Allocate<uint32_t>(10);
+        TEST_CHECK(after.data() != kept.data());
+
+        for(uint32_t i = 0; i < kept.size(); ++i) TEST_CHECK(kept[i] == i);
+    }
+}
+
+void TestRewindInOverflowBlocks()
+{
+    // Empty buffer, every allocation of the first frame lands in an overflow block
+    FrameArena arena;
+    arena.Reset();
+
+    std::span<uint32_t> kept = arena.Allocate<uint32_t>(2000);
+    for(uint32_t i = 0; i < kept.size(); ++i) kept[i] = i;
+
+    const FrameArena::Marker marker = arena.GetMarker();
+
+    AllocateScratch(arena);
+    arena.Rewind(marker);
+
+    // Rewound blocks are reused, the repetitions make no heap allocation
+    const uint64_t allocationsBefore = GetAllocationsCount();
+    for(uint32_t rep = 0; rep < 50; ++rep)
+    {
+        AllocateScratch(arena);
+        arena.Rewind(marker);
+    }
+    TEST_CHECK(GetAllocationsCount() == allocationsBefore);
+
+    for(uint32_t i = 0; i < kept.size(); ++i) TEST_CHECK(kept[i] == i);
+}
+
+void TestResetGrowsBuffer()
+{
+    FrameArena arena;
+
+    // The first frame overflows, the next Reset sizes the buffer for it
+    arena.Reset();
+    AllocateScratch(arena);
+    arena.Reset();
+
+    const size_t capacity = arena.GetCapacity();
+    TEST_CHECK(capacity > 0);
+
+    const uint64_t allocationsBefore = GetAllocationsCount();
+    for(uint32_t frame = 0; frame < 10; ++frame)
+    {
+        const FrameArena::Marker marker = arena.GetMarker();
+        AllocateScratch(arena);
+        arena.Rewind(marker);
+        AllocateScratch(arena);
+        arena.Reset();
+    }
+    TEST_CHECK(GetAllocationsCount() == allocationsBefore);
+    TEST_CHECK(arena.GetCapacity() == capacity);
+}
+
+int main()
+{
+    TestRewindKeepsEarlierAllocations();
+    TestRewindInOverflowBlocks();
+    TestResetGrowsBuffer();
+
+    return TestsResult("FrameArenaTests");
+}
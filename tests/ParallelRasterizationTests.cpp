@@ -0,0 +1,96 @@
+// Framebuffer frames of the parallel rasterizations and of the breadth first scheduler against the serial
+// depth first ones, in every rasterization mode
+
+#include <iterator>
+#include <random>
+
+#include "Renderer/WorldRasterizer.hpp"
+#include "TestHelpers.hpp"
+
+constexpr uint32_t GridSize = 12;
+// Sectors with two solid edges or more reach WallBvhMinWallsCount, Ray frames then go through
+// both the wall BVH and the plain wall loop
+constexpr uint32_t Subdivisions = WallBvhMinWallsCount / 2;
+constexpr uint32_t FrameWidth = 640;
+constexpr uint32_t FrameHeight = 360;
+
+constexpr RasterizationMode Modes[] = {
+    RasterizationMode::Ray,
+    RasterizationMode::WallSpan,
+    RasterizationMode::SimdBatch,
+    RasterizationMode::RayPacket,
+};
+
+struct RasterizerOptions
+{
+    RasterizerParallelism parallelism;
+    RenderAreaScheduler scheduler;
+};
+
+// The first one is the serial depth first reference
+constexpr RasterizerOptions OptionsList[] = {
+    { RasterizerParallelism::Serial, RenderAreaScheduler::DepthFirst },
+    { RasterizerParallelism::ColumnStrips, RenderAreaScheduler::DepthFirst },
+    { RasterizerParallelism::PortalTasks, RenderAreaScheduler::DepthFirst },
+    { RasterizerParallelism::Serial, RenderAreaScheduler::BreadthFirst },
+    { RasterizerParallelism::ColumnStrips, RenderAreaScheduler::BreadthFirst },
+};
+
+constexpr size_t ModesCount = std::size(Modes);
+constexpr size_t OptionsCount = std::size(OptionsList);
+
+void TestParallelFrames(FramebufferFormat format)
+{
+    World world;
+    BuildGridTestWorld(world, GridSize, 20, Subdivisions, 42);
+
+    // Kept between frames so their caches, arenas and worker contexts are reused like in the editor
+    WorldRasterizer rasterizers[ModesCount][OptionsCount];
+
+    for(size_t m = 0; m < ModesCount; ++m)
+    {
+        for(size_t o = 0; o < OptionsCount; ++o)
+        {
+            rasterizers[m][o].SetBackend(RasterizerBackend::Framebuffer);
+            rasterizers[m][o].SetFramebufferFormat(format);
+            rasterizers[m][o].SetRasterizationMode(Modes[m]);
+            rasterizers[m][o].SetParallelism(OptionsList[o].parallelism);
+            rasterizers[m][o].SetScheduler(OptionsList[o].scheduler);
+        }
+    }
+
+    std::mt19937 rng(7);
+
+    for(uint32_t maxPortalDepth : { 1U, 3U, 400U })
+    {
+        for(uint32_t view = 0; view < 10; ++view)
+        {
+            const RaycastingCamera cam = RandomGridTestCamera(world, GridSize, rng, maxPortalDepth);
+
+            for(auto& modeRasterizers : rasterizers)
+            {
+                for(WorldRasterizer& rasterizer : modeRasterizers)
+                {
+                    rasterizer.Reset(FrameWidth, FrameHeight, world, cam);
+                    rasterizer.RasterizeWorld();
+                }
+            }
+
+            for(auto& modeRasterizers : rasterizers)
+            {
+                for(size_t o = 1; o < OptionsCount; ++o)
+                {
+                    TEST_CHECK(IsSameFrame(modeRasterizers[o].GetFramebuffer(), modeRasterizers[0].GetFramebuffer()));
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestParallelFrames(FramebufferFormat::RGBA);
+    TestParallelFrames(FramebufferFormat::Palettized);
+
+    return TestsResult("ParallelRasterizationTests");
+}
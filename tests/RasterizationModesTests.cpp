@@ -0,0 +1,75 @@
+// Framebuffer frames of every rasterization mode against the Ray mode ones
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+
+#include "Renderer/WorldRasterizer.hpp"
+#include "TestHelpers.hpp"
+
+constexpr uint32_t GridSize = 12;
+// Sectors with two solid edges or more reach WallBvhMinWallsCount, Ray frames then go through
+// both the wall BVH and the plain wall loop
+constexpr uint32_t Subdivisions = WallBvhMinWallsCount / 2;
+constexpr uint32_t FrameWidth = 640;
+constexpr uint32_t FrameHeight = 360;
+
+constexpr RasterizationMode Modes[] = {
+    RasterizationMode::Ray,
+    RasterizationMode::WallSpan,
+    RasterizationMode::SimdBatch,
+    RasterizationMode::RayPacket,
+};
+
+constexpr size_t ModesCount = std::size(Modes);
+
+void TestModesFrames(FramebufferFormat format)
+{
+    World world;
+    BuildGridTestWorld(world, GridSize, 20, Subdivisions, 42);
+
+    RenderWorld renderWorld;
+    CompileRenderWorld(world, renderWorld);
+
+    const auto hasWallBvh = [](const RenderSector& sector) { return sector.wallBvhRoot != NULL_WALL_BVH_NODE; };
+    TEST_CHECK(std::ranges::any_of(renderWorld.sectors, hasWallBvh) && !std::ranges::all_of(renderWorld.sectors, hasWallBvh));
+
+    // Kept between frames so their caches and arenas are reused like in the editor
+    WorldRasterizer rasterizers[ModesCount];
+
+    for(size_t m = 0; m < ModesCount; ++m)
+    {
+        rasterizers[m].SetBackend(RasterizerBackend::Framebuffer);
+        rasterizers[m].SetFramebufferFormat(format);
+        rasterizers[m].SetRasterizationMode(Modes[m]);
+    }
+
+    std::mt19937 rng(7);
+
+    for(uint32_t maxPortalDepth : { 1U, 3U, 400U })
+    {
+        for(uint32_t view = 0; view < 15; ++view)
+        {
+            const RaycastingCamera cam = RandomGridTestCamera(world, GridSize, rng, maxPortalDepth);
+
+            for(WorldRasterizer& rasterizer : rasterizers)
+            {
+                rasterizer.Reset(FrameWidth, FrameHeight, world, cam);
+                rasterizer.RasterizeWorld();
+            }
+
+            for(size_t m = 1; m < ModesCount; ++m)
+            {
+                TEST_CHECK(IsSameFrame(rasterizers[m].GetFramebuffer(), rasterizers[0].GetFramebuffer()));
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestModesFrames(FramebufferFormat::RGBA);
+    TestModesFrames(FramebufferFormat::Palettized);
+
+    return TestsResult("RasterizationModesTests");
+}
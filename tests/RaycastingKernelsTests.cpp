@@ -0,0 +1,243 @@
+// SIMD, packet and BVH nearest hit kernels against RayToSegmentCollision on every wall
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "Renderer/RaycastingMath.hpp"
+#include "Renderer/RaycastingMathSimd.hpp"
+#include "Renderer/RenderWorld.hpp"
+#include "TestHelpers.hpp"
+
+// Walls stored the way RenderWorld::SectorWalls lays them out
+struct TestWallsSoA
+{
+    std::vector<float> ax, ay, bx, by;
+    std::vector<uint32_t> toSector;
+    size_t count { 0 };
+
+    explicit TestWallsSoA(const std::vector<Wall>& walls) : count(walls.size())
+    {
+        const size_t paddedCount = PaddedWallsCount(count);
+        ax.assign(paddedCount, 0);
+        ay.assign(paddedCount, 0);
+        bx.assign(paddedCount, 0);
+        by.assign(paddedCount, 0);
+        toSector.assign(paddedCount, static_cast<uint32_t>(-1));
+
+        for(size_t i = 0; i < count; ++i)
+        {
+            ax[i] = walls[i].segment.a.x;
+            ay[i] = walls[i].segment.a.y;
+            bx[i] = walls[i].segment.b.x;
+            by[i] = walls[i].segment.b.y;
+            toSector[i] = walls[i].toSector;
+        }
+    }
+
+    WallsSoAView View() const
+    {
+        return { ax.data(), ay.data(), bx.data(), by.data(), toSector.data(), count, PaddedWallsCount(count) };
+    }
+};
+
+// Reference rule of the kernels: portals seen from behind are skipped, the first nearest hit wins
+int32_t ScalarNearestHit(const RasterRay& ray, const std::vector<Wall>& walls, HitInfo& hitInfo)
+{
+    int32_t nearestIndex = -1;
+    float nearestDistance = std::numeric_limits<float>::max();
+
+    for(size_t i = 0; i < walls.size(); ++i)
+    {
+        const Segment& segment = walls[i].segment;
+        if(walls[i].toSector != NULL_SECTOR && PointSegmentSide(ray.position, segment.a, segment.b) <= 0) continue;
+
+        HitInfo hit;
+        if(!RayToSegmentCollision(ray, segment, hit) || hit.distance >= nearestDistance) continue;
+
+        nearestDistance = hit.distance;
+        nearestIndex = static_cast<int32_t>(i);
+        hitInfo = hit;
+    }
+
+    return nearestIndex;
+}
+
+std::vector<Wall> RandomWalls(std::mt19937& rng)
+{
+    std::vector<Wall> walls(1 + rng() % 40);
+
+    for(Wall& wall : walls)
+    {
+        wall.segment = {
+            { static_cast<float>(rng() % 1000), static_cast<float>(rng() % 1000) },
+            { static_cast<float>(rng() % 1000), static_cast<float>(rng() % 1000) },
+        };
+        if(rng() % 3 == 0) wall.toSector = 5;
+    }
+
+    return walls;
+}
+
+Vector2 RandomDirection(std::mt19937& rng)
+{
+    return Vector2DirectionFromAngle((rng() % 62830) / 10000.f);
+}
+
+std::vector<SimdLevel> SupportedSimdLevels()
+{
+    std::vector<SimdLevel> levels;
+    for(SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE4, SimdLevel::AVX2 })
+    {
+        if(level <= GetRasterSimdLevel()) levels.push_back(level);
+    }
+    return levels;
+}
+
+void TestRayToWallsNearestHit()
+{
+    std::mt19937 rng(3);
+
+    for(uint32_t test = 0; test < 20000; ++test)
+    {
+        const std::vector<Wall> walls = RandomWalls(rng);
+        const TestWallsSoA soa(walls);
+
+        const RasterRay ray {
+            .position = { static_cast<float>(rng() % 1000) + 0.5f, static_cast<float>(rng() % 1000) },
+            .direction = RandomDirection(rng),
+        };
+
+        HitInfo expectedHit;
+        const int32_t expectedIndex = ScalarNearestHit(ray, walls, expectedHit);
+
+        for(SimdLevel level : SupportedSimdLevels())
+        {
+            HitInfo hit;
+            const int32_t index = RayToWallsNearestHit(ray, soa.View(), hit, level);
+
+            TEST_CHECK(index == expectedIndex);
+            if(index == expectedIndex && index >= 0)
+            {
+                TEST_CHECK(hit.distance == expectedHit.distance);
+                TEST_CHECK(hit.position.x == expectedHit.position.x && hit.position.y == expectedHit.position.y);
+            }
+        }
+    }
+}
+
+void TestRayPacketToWallsNearestHits()
+{
+    std::mt19937 rng(5);
+
+    for(uint32_t test = 0; test < 20000; ++test)
+    {
+        const std::vector<Wall> walls = RandomWalls(rng);
+        const TestWallsSoA soa(walls);
+
+        RayPacket packet;
+        packet.position = { static_cast<float>(rng() % 1000) + 0.5f, static_cast<float>(rng() % 1000) };
+        packet.lanesCount = 1 + rng() % RayPacketSize;
+
+        for(uint32_t lane = 0; lane < packet.lanesCount; ++lane)
+        {
+            const Vector2 direction = RandomDirection(rng);
+            packet.directionX[lane] = direction.x;
+            packet.directionY[lane] = direction.y;
+        }
+
+        for(SimdLevel level : SupportedSimdLevels())
+        {
+            RayPacketHits hits;
+            RayPacketToWallsNearestHits(packet, soa.View(), hits, level);
+
+            for(uint32_t lane = 0; lane < packet.lanesCount; ++lane)
+            {
+                const RasterRay ray { .position = packet.position, .direction = { packet.directionX[lane], packet.directionY[lane] } };
+
+                HitInfo expectedHit;
+                const int32_t expectedIndex = ScalarNearestHit(ray, walls, expectedHit);
+
+                TEST_CHECK(hits.wallIndices[lane] == expectedIndex);
+                if(hits.wallIndices[lane] == expectedIndex && expectedIndex >= 0)
+                {
+                    TEST_CHECK(hits.distances[lane] == expectedHit.distance);
+                    TEST_CHECK(hits.positionsX[lane] == expectedHit.position.x && hits.positionsY[lane] == expectedHit.position.y);
+                }
+            }
+        }
+    }
+}
+
+void TestRayToSectorWallBvhNearestHit()
+{
+    // Enough subdivisions for the border sectors to get a wall BVH
+    World world;
+    BuildGridTestWorld(world, 12, 20, 40, 42);
+
+    RenderWorld renderWorld;
+    CompileRenderWorld(world, renderWorld);
+
+    std::mt19937 rng(1);
+    uint32_t testedSectorsCount = 0;
+
+    for(SectorIndex sectorIndex = 0; sectorIndex < renderWorld.sectors.size(); ++sectorIndex)
+    {
+        const RenderSector& sector = renderWorld.sectors[sectorIndex];
+        if(sector.wallBvhRoot == NULL_WALL_BVH_NODE) continue;
+
+        ++testedSectorsCount;
+
+        for(uint32_t test = 0; test < 500; ++test)
+        {
+            const SectorIndex viewSectorIndex = rng() % renderWorld.sectors.size();
+            const RasterRay ray {
+                .position = { static_cast<float>(rng() % 1200), static_cast<float>(rng() % 1200) },
+                .direction = RandomDirection(rng),
+            };
+
+            HitInfo hit;
+            const WallIndex index = RayToSectorWallBvhNearestHit(renderWorld, sectorIndex, viewSectorIndex, ray, hit);
+
+            // Every wall of the sector, portals to sectors the view sector cannot see are skipped too
+            WallIndex expectedIndex = NULL_WALL_INDEX;
+            HitInfo expectedHit;
+            expectedHit.distance = std::numeric_limits<float>::max();
+
+            for(WallIndex wallIndex = sector.wallsBegin; wallIndex < sector.wallsBegin + sector.wallsCount; ++wallIndex)
+            {
+                const Segment segment = renderWorld.WallSegment(wallIndex);
+                const SectorIndex toSector = renderWorld.wallToSector[wallIndex];
+
+                if(toSector != NULL_SECTOR_INDEX
+                    && (PointSegmentSide(ray.position, segment.a, segment.b) <= 0 || !renderWorld.IsSectorPotentiallyVisible(viewSectorIndex, toSector)))
+                {
+                    continue;
+                }
+
+                HitInfo wallHit;
+                if(!RayToSegmentCollision(ray, segment, wallHit) || wallHit.distance >= expectedHit.distance) continue;
+
+                expectedIndex = wallIndex;
+                expectedHit = wallHit;
+            }
+
+            TEST_CHECK(index == expectedIndex);
+            if(index == expectedIndex && index != NULL_WALL_INDEX)
+            {
+                TEST_CHECK(hit.distance == expectedHit.distance);
+            }
+        }
+    }
+
+    TEST_CHECK(testedSectorsCount > 0);
+}
+
+int main()
+{
+    TestRayToWallsNearestHit();
+    TestRayPacketToWallsNearestHits();
+    TestRayToSectorWallBvhNearestHit();
+
+    return TestsResult("RaycastingKernelsTests");
+}
@@ -0,0 +1,137 @@
+// Potentially visible sets: frames culled with them against frames without them, background builds against synchronous ones
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <ranges>
+
+#include "Renderer/SectorPvs.hpp"
+#include "Renderer/WorldRasterizer.hpp"
+#include "TestHelpers.hpp"
+
+constexpr uint32_t GridSize = 12;
+constexpr uint32_t FrameWidth = 640;
+constexpr uint32_t FrameHeight = 360;
+
+constexpr RasterizationMode Modes[] = {
+    RasterizationMode::Ray,
+    RasterizationMode::WallSpan,
+    RasterizationMode::SimdBatch,
+    RasterizationMode::RayPacket,
+};
+
+constexpr size_t ModesCount = std::size(Modes);
+
+// A set leaving out a sector some ray can reach through the portals changes the frame
+void TestSetsAreConservative()
+{
+    World world;
+    BuildGridTestWorld(world, GridSize, 20, WallBvhMinWallsCount / 2, 42);
+
+    RenderWorld culledWorld;
+    CompileRenderWorld(world, culledWorld);
+    BuildSectorsPvs(culledWorld);
+
+    // Otherwise the frames would match whatever the sets hold
+    bool isAnySectorCulled = false;
+    for(SectorIndex sectorIndex = 0; sectorIndex < culledWorld.sectors.size(); ++sectorIndex)
+    {
+        isAnySectorCulled |= CountPotentiallyVisibleSectors(culledWorld, sectorIndex) < culledWorld.sectors.size();
+    }
+    TEST_CHECK(isAnySectorCulled);
+
+    RenderWorld unculledWorld = culledWorld;
+    unculledWorld.sectorsPvs.clear();
+
+    WorldRasterizer culledRasterizers[ModesCount];
+    WorldRasterizer unculledRasterizers[ModesCount];
+
+    for(size_t m = 0; m < ModesCount; ++m)
+    {
+        for(WorldRasterizer* rasterizer : { &culledRasterizers[m], &unculledRasterizers[m] })
+        {
+            rasterizer->SetBackend(RasterizerBackend::Framebuffer);
+            rasterizer->SetRasterizationMode(Modes[m]);
+        }
+    }
+
+    std::mt19937 rng(11);
+
+    for(uint32_t view = 0; view < 40; ++view)
+    {
+        const RaycastingCamera cam = RandomGridTestCamera(world, GridSize, rng, 400);
+
+        for(size_t m = 0; m < ModesCount; ++m)
+        {
+            culledRasterizers[m].Reset(FrameWidth, FrameHeight, culledWorld, cam);
+            culledRasterizers[m].RasterizeWorld();
+            unculledRasterizers[m].Reset(FrameWidth, FrameHeight, unculledWorld, cam);
+            unculledRasterizers[m].RasterizeWorld();
+
+            TEST_CHECK(IsSameFrame(culledRasterizers[m].GetFramebuffer(), unculledRasterizers[m].GetFramebuffer()));
+        }
+    }
+}
+
+void TestBackgroundBuild()
+{
+    World world;
+    BuildGridTestWorld(world, GridSize, 20, 3, 42);
+
+    RenderWorld renderWorld;
+    CompileRenderWorld(world, renderWorld);
+    TEST_CHECK(renderWorld.sectorsPvs.empty());
+
+    RenderWorld expectedWorld = renderWorld;
+    BuildSectorsPvs(expectedWorld);
+
+    SectorPvsBuilder builder;
+    builder.Update(renderWorld);
+    builder.Wait();
+    TEST_CHECK(!builder.IsBuilding());
+
+    builder.Update(renderWorld);
+    TEST_CHECK(renderWorld.sectorsPvs == expectedWorld.sectorsPvs);
+    TEST_CHECK(renderWorld.pvsWordsPerSector == expectedWorld.pvsWordsPerSector);
+
+    // Height edits keep the sets
+    const uint64_t layoutRevision = renderWorld.layoutRevision;
+    world.Sectors.begin()->second.zFloor = 0.5f;
+    world.MarkModified();
+    CompileRenderWorld(world, renderWorld);
+    TEST_CHECK(renderWorld.layoutRevision == layoutRevision);
+    TEST_CHECK(renderWorld.sectorsPvs == expectedWorld.sectorsPvs);
+
+    // Wall edits drop them, the build started for a layout edited again is cancelled and never handed over
+    for(uint32_t edit = 0; edit < 2; ++edit)
+    {
+        world.Sectors.erase(std::ranges::max(world.Sectors | std::views::keys));
+        for(auto& [ sectorId, sector ] : world.Sectors)
+        {
+            std::erase_if(sector.walls, [&world](const Wall& wall) { return wall.toSector != NULL_SECTOR && !world.Sectors.contains(wall.toSector); });
+        }
+        world.MarkModified();
+
+        CompileRenderWorld(world, renderWorld);
+        TEST_CHECK(renderWorld.layoutRevision == layoutRevision + edit + 1);
+        TEST_CHECK(renderWorld.sectorsPvs.empty());
+
+        builder.Update(renderWorld);
+    }
+
+    builder.Wait();
+    builder.Update(renderWorld);
+
+    expectedWorld = renderWorld;
+    expectedWorld.sectorsPvs.clear();
+    BuildSectorsPvs(expectedWorld);
+    TEST_CHECK(!renderWorld.sectorsPvs.empty() && renderWorld.sectorsPvs == expectedWorld.sectorsPvs);
+}
+
+int main()
+{
+    TestSetsAreConservative();
+    TestBackgroundBuild();
+
+    return TestsResult("SectorPvsTests");
+}
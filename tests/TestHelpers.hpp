@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Renderer/Framebuffer.hpp"
+#include "Renderer/RaycastingCamera.hpp"
+#include "Renderer/World.hpp"
+
+// Failed checks of the test executable, its exit code
+inline int testFailuresCount = 0;
+
+// Reports the failure and keeps going, so one run lists every mismatch
+#define TEST_CHECK(condition) \
+    do { \
+        if(!(condition)) { \
+            ++testFailuresCount; \
+            if(testFailuresCount <= 20) printf("%s:%d check failed: %s\n", __FILE__, __LINE__, #condition); \
+        } \
+    } while(false)
+
+inline int TestsResult(const char* testsName)
+{
+    printf("%s: %d failed checks\n", testsName, testFailuresCount);
+    return testFailuresCount == 0 ? 0 : 1;
+}
+
+constexpr float GridTestWorldCellSize = 100.f;
+
+inline SectorID GridTestWorldSectorId(uint32_t gridSize, uint32_t row, uint32_t column)
+{
+    return 1 + row * gridSize + column;
+}
+
+/// @brief Fills world with a gridSize x gridSize grid of square sectors, open neighbours are linked by portals
+/// Cells are blocked with a blockedPercent chance (never the first one), solid edges are split in subdivisions walls
+/// of random colors, a third of them textured. Floor and ceiling heights are random too.
+/// Only rng() % n is used so the world is the same with every standard library.
+inline void BuildGridTestWorld(World& world, uint32_t gridSize, uint32_t blockedPercent, uint32_t subdivisions, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+
+    std::vector<bool> blocked(gridSize * gridSize);
+    for(size_t i = 0; i < blocked.size(); ++i) blocked[i] = rng() % 100 < blockedPercent;
+    blocked[0] = false;
+
+    const auto isOpen = [&](int64_t row, int64_t column) {
+        return row >= 0 && row < gridSize && column >= 0 && column < gridSize && !blocked[row * gridSize + column];
+    };
+
+    world.Sectors.clear();
+
+    uint32_t solidWallsCount = 0;
+
+    for(uint32_t row = 0; row < gridSize; ++row)
+    {
+        for(uint32_t column = 0; column < gridSize; ++column)
+        {
+            if(blocked[row * gridSize + column]) continue;
+
+            const float x0 = column * GridTestWorldCellSize;
+            const float x1 = (column + 1) * GridTestWorldCellSize;
+            const float y0 = row * GridTestWorldCellSize;
+            const float y1 = (row + 1) * GridTestWorldCellSize;
+
+            const Vector2 corners[4] = { { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y1 } };
+            const int64_t neighbourRows[4] = { int64_t(row) - 1, row, row + 1, row };
+            const int64_t neighbourColumns[4] = { column, column + 1, column, int64_t(column) - 1 };
+
+            Sector sector;
+
+            for(uint32_t edge = 0; edge < 4; ++edge)
+            {
+                const Vector2 a = corners[edge];
+                const Vector2 b = corners[(edge + 1) % 4];
+
+                if(isOpen(neighbourRows[edge], neighbourColumns[edge]))
+                {
+                    sector.walls.push_back({
+                        .segment = { a, b },
+                        .toSector = GridTestWorldSectorId(gridSize, neighbourRows[edge], neighbourColumns[edge]),
+                    });
+                    continue;
+                }
+
+                for(uint32_t k = 0; k < subdivisions; ++k)
+                {
+                    const Vector2 p = Vector2Lerp(a, b, static_cast<float>(k) / subdivisions);
+                    const Vector2 q = Vector2Lerp(a, b, static_cast<float>(k + 1) / subdivisions);
+
+                    Wall wall {
+                        .segment = { p, q },
+                        .color = { static_cast<unsigned char>(rng() % 256), static_cast<unsigned char>(rng() % 256), static_cast<unsigned char>(rng() % 256), 255 },
+                    };
+                    if(solidWallsCount++ % 3 == 0) wall.texture = 0;
+
+                    sector.walls.push_back(wall);
+                }
+            }
+
+            sector.zFloor = 0.7f + 0.003f * (rng() % 100);
+            sector.zCeiling = 0.7f + 0.003f * (rng() % 100);
+
+            world.Sectors.emplace(GridTestWorldSectorId(gridSize, row, column), std::move(sector));
+        }
+    }
+
+    world.InitWorld();
+}
+
+/// @brief Camera at a random position inside one of the sectors of a BuildGridTestWorld world, random yaw, pitch and fov
+inline RaycastingCamera RandomGridTestCamera(const World& world, uint32_t gridSize, std::mt19937& rng, uint32_t maxPortalDepth)
+{
+    RaycastingCamera cam;
+    cam.maxPortalDepth = maxPortalDepth;
+    cam.farPlaneDistance = 2000;
+
+    const uint32_t worldSize = gridSize * static_cast<uint32_t>(GridTestWorldCellSize);
+
+    do
+    {
+        cam.position = { static_cast<float>(rng() % worldSize), static_cast<float>(rng() % worldSize) };
+        cam.currentSectorId = FindSectorOfPoint(cam.position, world);
+    } while(cam.currentSectorId == NULL_SECTOR);
+
+    cam.yaw = (rng() % 6283) / 1000.f;
+    cam.pitch = (static_cast<int>(rng() % 100) - 50) / 100.f;
+    cam.fov = 50 + rng() % 70;
+
+    return cam;
+}
+
+// Same size, format and pixels
+inline bool IsSameFrame(const Framebuffer& a, const Framebuffer& b)
+{
+    if(a.format != b.format || a.width != b.width || a.height != b.height) return false;
+
+    if(a.format == FramebufferFormat::RGBA)
+    {
+        return a.pixels.size() == b.pixels.size() && std::memcmp(a.pixels.data(), b.pixels.data(), a.pixels.size() * sizeof(Color)) == 0;
+    }
+
+    return a.indices == b.indices;
+}
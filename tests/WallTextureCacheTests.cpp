@@ -0,0 +1,69 @@
+// WallTextureCache budget: least recently used evictions, textures that can never fit
+
+#include <vector>
+
+#include "Renderer/WallTextureCache.hpp"
+#include "TestHelpers.hpp"
+
+// Bitset of the given textures, like the one the rasterizer fills
+std::vector<uint64_t> RequestedTextures(std::initializer_list<WallTextureID> textureIds)
+{
+    std::vector<uint64_t> requestedTextures(1, 0);
+    for(WallTextureID textureId : textureIds) requestedTextures[0] |= uint64_t(1) << textureId;
+
+    return requestedTextures;
+}
+
+bool IsResident(const WallTextureCache& cache, WallTextureID textureId)
+{
+    return cache.textureBlocks[textureId] != NULL_WALL_TEXTURE_BLOCK;
+}
+
+void TestBudget()
+{
+    // Too big for the atlas, each texture is a block of its own
+    std::vector<WallTextureSource> sources(5);
+    for(WallTextureSource& source : sources) source.bricksSize = 128;
+    sources[3].bricksSize = 512;
+
+    WallTextureCache cache;
+    SyncWallTextureCacheSources(cache, sources);
+
+    UpdateWallTextureCache(cache, RequestedTextures({ 0 }));
+    TEST_CHECK(IsResident(cache, 0));
+
+    // Room for three of the small textures
+    cache.budgetBytes = 3 * cache.residentBytes + cache.residentBytes / 2;
+
+    UpdateWallTextureCache(cache, RequestedTextures({ 1 }));
+    UpdateWallTextureCache(cache, RequestedTextures({ 2 }));
+    TEST_CHECK(IsResident(cache, 0) && IsResident(cache, 1) && IsResident(cache, 2));
+
+    // Bigger than the whole budget, nothing is evicted for it
+    for(uint32_t frame = 0; frame < 3; ++frame)
+    {
+        UpdateWallTextureCache(cache, RequestedTextures({ 3 }));
+    }
+    TEST_CHECK(!IsResident(cache, 3) && cache.overBudget[3]);
+    TEST_CHECK(cache.evictionsCount == 0 && cache.loadsCount == 3);
+    TEST_CHECK(IsResident(cache, 0) && IsResident(cache, 1) && IsResident(cache, 2));
+    TEST_CHECK(!HasMissingWallTextures(cache, RequestedTextures({ 3 })));
+
+    // Only the least recently used block makes room for a small one
+    UpdateWallTextureCache(cache, RequestedTextures({ 1, 2, 4 }));
+    TEST_CHECK(!IsResident(cache, 0) && IsResident(cache, 1) && IsResident(cache, 2) && IsResident(cache, 4));
+    TEST_CHECK(cache.evictionsCount == 1);
+    TEST_CHECK(cache.residentBytes <= cache.budgetBytes);
+
+    // Requested textures are kept even when a new one does not fit next to them
+    UpdateWallTextureCache(cache, RequestedTextures({ 0, 1, 2, 4 }));
+    TEST_CHECK(!IsResident(cache, 0) && cache.overBudget[0]);
+    TEST_CHECK(IsResident(cache, 1) && IsResident(cache, 2) && IsResident(cache, 4));
+}
+
+int main()
+{
+    TestBudget();
+
+    return TestsResult("WallTextureCacheTests");
+}